@@ -4,8 +4,9 @@
 
 int main(int ac, char **av) {
 
-    //init MPI
-    MPI_Init(&ac, &av);
+    //init MPI: grid kernels may run on threads, only the main one calls MPI
+    int provided;
+    MPI_Init_thread(&ac, &av, MPI_THREAD_FUNNELED, &provided);
     
     SimulationManager simMng(ac, av);
     simMng.runSimulation(ac, av);
@@ -0,0 +1,56 @@
+#ifndef FieldView_hpp
+#define FieldView_hpp
+
+#include <stdio.h>
+
+//  alignment (bytes) of every component array of the field storage
+#define FIELD_ALIGNMENT 64
+
+//  view of one variable in the structure-of-arrays field storage:
+//  each component is a contiguous array of all nodes, component dim
+//  of node idx is data[dim*stride+idx].
+//  EXTRA is the number of nodes added to the resolution along each axis,
+//  so that views of different grids can not be mixed up
+template<int EXTRA>
+class FieldView{
+
+private:
+    double* data;
+    int size;
+    long stride;
+
+public:
+    FieldView():data(nullptr), size(0), stride(0){}
+    FieldView(double* data, int size, long stride):data(data), size(size), stride(stride){}
+
+    double& operator()(int idx, int dim) const {
+        return data[dim*stride+idx];
+    }
+
+    double* getComponent(int dim) const {
+        return data+dim*stride;
+    }
+
+    double* getData() const {
+        return data;
+    }
+
+    int getSize() const {
+        return size;
+    }
+
+    long getStride() const {
+        return stride;
+    }
+};
+
+typedef FieldView<1> FieldG1;
+typedef FieldView<2> FieldG2;
+
+//  number of doubles of a component array of nodesNum nodes
+inline long alignedStride(long nodesNum){
+    long perLine = FIELD_ALIGNMENT/sizeof(double);
+    return (nodesNum+perLine-1)/perLine*perLine;
+}
+
+#endif /* FieldView_hpp */
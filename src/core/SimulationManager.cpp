@@ -91,19 +91,28 @@ void SimulationManager::initialize() {
 
     loader.reset(new Loader());
     loader->load();
+    
+    setThreadsNum(loader->gridThreads);
+    if( getThreadsNum() != loader->gridThreads ){
+        logger->writeMsg("[SimulationManager] built without OpenMP, grid kernels run on one thread", CRITICAL);
+    }
         
-    gridMng.reset(new GridManager(loader));
-    boundMng.reset(new BoundaryManager(loader));
+    workspace.reset(new Workspace());
+    gridMng.reset(new GridManager(loader, workspace));
+    boundMng.reset(new BoundaryManager(loader, gridMng, workspace));
     
-    pusher.reset(new Pusher(loader, gridMng, boundMng));
+    pusher.reset(new Pusher(loader, gridMng, boundMng, workspace));
     
     initMng.reset(new ModelInitializer(loader, gridMng, pusher));
     
     laserMng.reset(new LaserMockManager(loader, gridMng, pusher));
-    hydroMng.reset(new HydroManager(loader, gridMng, pusher));
-    closureMng.reset(new ClosureManager(loader, gridMng));
+    hydroMng.reset(new HydroManager(loader, gridMng, pusher, workspace));
+    closureMng.reset(new ClosureManager(loader, gridMng, workspace));
     elemagMng.reset(new EleMagManager(loader, gridMng));
-    collideMng.reset(new IonIonCollisionManager(loader, gridMng, pusher));
+    //# collisions run on a worker thread of the solver next to the stages
+    //# borrowing from the shared workspace, so they have their own
+    collideMng.reset(new IonIonCollisionManager(loader, gridMng, pusher,
+                                                shared_ptr<Workspace>(new Workspace())));
     solver.reset(new Solver(loader, gridMng, pusher,
                             hydroMng, elemagMng, closureMng,
                             laserMng, collideMng));    
@@ -121,6 +130,12 @@ void SimulationManager::runSimulation(int ac, char **av) {
     int maxTimeStep2Write = loader->getTimestepsNum2Write();
     int fileNumCount = 0;
     int i_time;
+    
+    //# with adaptiveTimeStep files follow the simulation time, every
+    //# timestepsNum2Write of the initial timesteps
+    double outputInterval = maxTimeStep2Write*loader->getTimeStep();
+    double nextOutputTime = 0.0;
+    
     int STOP_SIMULATION = 1;
 
     int rank ;
@@ -134,15 +149,24 @@ void SimulationManager::runSimulation(int ac, char **av) {
             logger->writeMsg(string("[SimulationManager] step = "
                                     +to_string(i_time)).c_str(), INFO);
             logger->writeMsg(string("[SimulationManager] time = "
-                                    +to_string(i_time*loader->getTimeStep())).c_str(), INFO);
+                                    +to_string(solver->getSimulationTime())).c_str(), INFO);
             logger->writeMsg("****                                             ****", INFO);
             logger->writeMsg("*****************************************************", INFO);
         }
-        if( i_time % maxTimeStep2Write == 0 ){
+        bool write2file = i_time % maxTimeStep2Write == 0;
+        if( loader->adaptiveTimeStep ){
+            double time = solver->getSimulationTime()+0.5*loader->getTimeStep();
+            write2file = time >= nextOutputTime;
+            while( nextOutputTime <= time ){
+                nextOutputTime += outputInterval;
+            }
+        }
+        if( write2file ){
             #ifdef GET_ION_PRESSURE
             hydroMng->setIonPressureTensor();
             #endif
 
+            gridMng->flushHalos(nullptr);
             writer->write(fileNumCount);
             
             #ifdef WRITE_PARTICLES
@@ -192,6 +216,30 @@ void SimulationManager::runSimulation(int ac, char **av) {
         string msg = "**** Total duration for "+to_string(i_time)+" steps : "
                     +to_string(duration_cast<minutes>(end_time_tot - start_time_tot).count())+" min";
         logger->writeMsg(msg.c_str(), INFO);
+        msg = "**** communication rounds saved by coalescing = "
+              +to_string(gridMng->getCommRoundsSaved());
+        logger->writeMsg(msg.c_str(), INFO);
+        msg = "**** derived fields computed "+to_string(gridMng->getDerivedComputed())
+              +" times, reused "+to_string(gridMng->getDerivedReused())+" times";
+        logger->writeMsg(msg.c_str(), INFO);
+        msg = "**** E, J halos in flight during "+to_string((int) gridMng->getHaloOverlapTime())
+              +" ms of compute, waited "+to_string((int) gridMng->getHaloWaitTime())+" ms";
+        logger->writeMsg(msg.c_str(), INFO);
+        msg = "**** solver stages took "+to_string((int) solver->getStagesTime())
+              +" ms, critical path of their dependency graph "
+              +to_string((int) solver->getCriticalPathTime())+" ms";
+        logger->writeMsg(msg.c_str(), INFO);
+        msg = "**** scratch workspace high-water mark "
+              +to_string(workspace->getHighWaterMark()/1024)+" kB, "
+              +to_string(workspace->getHeapAllocationsNum())+" heap allocations";
+        logger->writeMsg(msg.c_str(), INFO);
+        if( loader->adaptiveTimeStep ){
+            msg = "**** timeStep in ["+to_string(solver->getMinUsedTimeStep())+", "
+                  +to_string(solver->getMaxUsedTimeStep())+"], "
+                  +to_string(solver->getRejectedStepsNum())+" steps rejected, time = "
+                  +to_string(solver->getSimulationTime());
+            logger->writeMsg(msg.c_str(), INFO);
+        }
         logger->writeMsg("****                                             ****", INFO);
         logger->writeMsg("*****************************************************", INFO);
     }
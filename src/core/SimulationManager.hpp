@@ -19,6 +19,7 @@
 #include "../physics/collisions/IonIonCollisionManager.hpp"
 
 #include "../misc/Logger.hpp"
+#include "../misc/Workspace.hpp"
 #include "../output/Writer.hpp"
 
 #include "../solvers/Solver.hpp"
@@ -29,6 +30,7 @@
 class SimulationManager {
 private:
     std::unique_ptr<Logger> logger;
+    std::shared_ptr<Workspace> workspace;
     std::shared_ptr<GridManager> gridMng;
     std::shared_ptr<BoundaryManager> boundMng;
     
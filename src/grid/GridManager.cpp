@@ -3,8 +3,9 @@
 using namespace std;
 using namespace chrono;
 
-GridManager::GridManager(shared_ptr<Loader> loader){
+GridManager::GridManager(shared_ptr<Loader> loader, shared_ptr<Workspace> workspace){
     this->loader=loader;
+    this->workspace=workspace;
     logger.reset(new Logger());
     initialize();
     string msg ="[GridManager] init...OK {Node number:"+to_string(totalNodeNumber)+"}";
@@ -13,114 +14,359 @@ GridManager::GridManager(shared_ptr<Loader> loader){
 
 
 GridManager::~GridManager(){
-    delete [] neibors4G2spatialDerX;
-    delete [] neibors4G2spatialDerY;
-    delete [] neibors4G2spatialDerZ;
-    delete [] negbors4PresX;
-    delete [] negbors4PresY;
-    delete [] negbors4PresZ;
-    delete [] negbors4LaplacX;
-    delete [] negbors4LaplacY;
-    delete [] negbors4LaplacZ;
-    delete [] neibors4G1spatialDerX;
-    delete [] neibors4G1spatialDerY;
-    delete [] neibors4G1spatialDerZ;
-    delete [] neighbourhood;
-    delete [] nodesG2vars;
-    delete [] nodesG1vars;
-    
-    for (int t = 0; t < 27; t++) {
-        delete [] sendIdx4Gath[t];
-        delete [] recvIdx4Gath[t];
-        delete [] sendIdxOnG4[t];
-        delete [] recvIdxOnG4[t];
-        delete [] sendIdx[t];
-        delete [] recvIdx[t];
-    }
-}
-
-const int* GridManager::getNeighbourhoodOnG1(){
-    return neighbourhood;
+    free(fieldsG1);
+    free(derivedFields);
+    
+    int finalized;
+    MPI_Finalized(&finalized);
+    if( !finalized ){
+        for( int n = 0; n < haloTypes.size(); n++ ){
+            MPI_Type_free(&haloTypes[n]);
+        }
+    }
+    
+    if( nodeWin == MPI_WIN_NULL ){
+        free(fieldsG2);
+    }else if( !finalized ){
+        MPI_Win_free(&nodeWin);
+    }
 }
 
-void GridManager::initialize(){
-    logger->writeMsg("[GridManager] initialize() ...", DEBUG);
-    
-    int xRes = loader->resolution[0];
-    int yRes = loader->resolution[1];
-    int zRes = loader->resolution[2];
-    
-    this->totalNodeNumber = xRes*yRes*zRes;
-    
-    this->G1nodesNumber = (xRes+1)*(yRes+1)*(zRes+1);
-    this->G2nodesNumber = (xRes+2)*(yRes+2)*(zRes+2);
+
+//  G2 storage is allocated in a shared window of the node,
+//  neighbours on the node read their ghost values directly from it
+void GridManager::initSharedStorage(){
     
-     neibors4G2spatialDerX = new int[G2nodesNumber*8*sizeof(int)];
-     neibors4G2spatialDerY = new int[G2nodesNumber*8*sizeof(int)];
-     neibors4G2spatialDerZ = new int[G2nodesNumber*8*sizeof(int)];
+    int t, dispUnit;
+    MPI_Aint winSize;
+    MPI_Status st;
+    void* nbStore;
+    long totComps = firstCompG2[totVarsOnG2-1]+varSizeG2[totVarsOnG2-1];
     
-     negbors4PresX = new int[G2nodesNumber*18*sizeof(int)];
-     negbors4PresY = new int[G2nodesNumber*18*sizeof(int)];
-     negbors4PresZ = new int[G2nodesNumber*18*sizeof(int)];
+    MPI_Win_allocate_shared(sizeof(double)*strideG2*totComps, sizeof(double),
+                            MPI_INFO_NULL, loader->nodeComm, &fieldsG2, &nodeWin);
     
-     negbors4LaplacX = new int[G2nodesNumber*4*sizeof(int)];
-     negbors4LaplacY = new int[G2nodesNumber*4*sizeof(int)];
-     negbors4LaplacZ = new int[G2nodesNumber*4*sizeof(int)];
+    int onNode = 0;
+    for( t = 0; t < 27; t++ ){
+        
+        //# domains may differ by one cell, the sender's size is needed
+        MPI_Sendrecv(loader->resolution, 3, MPI_INT, loader->neighbors2Send[t], t,
+                     nodeNeighborRes[t], 3, MPI_INT, loader->neighbors2Recv[t], t,
+                     MPI_COMM_WORLD, &st);
+        
+        nodeNeighborStore[t] = nullptr;
+        if( loader->nodeNeighbors2Recv[t] != MPI_PROC_NULL ){
+            MPI_Win_shared_query(nodeWin, loader->nodeNeighbors2Recv[t],
+                                 &winSize, &dispUnit, &nbStore);
+            nodeNeighborStore[t] = (double*) nbStore;
+            onNode++;
+        }
+    }
     
-     neibors4G1spatialDerX = new int[G1nodesNumber*8*sizeof(int)];
-     neibors4G1spatialDerY = new int[G1nodesNumber*8*sizeof(int)];
-     neibors4G1spatialDerZ = new int[G1nodesNumber*8*sizeof(int)];
+    string msg ="[GridManager] shared G2 storage: "+to_string(onNode)
+                +" of neighbours are on the node";
+    logger->writeMsg(msg.c_str(), DEBUG);
+}
 
-    neighbourhood = new int[G1nodesNumber*8*sizeof(int)];
+static double* allocAligned(long doublesNum){
+    void* ptr = nullptr;
+    if( posix_memalign(&ptr, FIELD_ALIGNMENT, sizeof(double)*max(doublesNum, 1L)) != 0 ){
+        throw runtime_error("field storage allocation failed!");
+    }
+    return (double*) ptr;
+}
 
+
+//  zeroes comps components of stride doubles. Each thread writes the same
+//  part of every component, the one the static schedule of the kernels
+//  over tiles in node order gives it, so the pages of its part are placed
+//  on its NUMA node by the first touch
+static void firstTouch(double* data, long stride, long comps){
+    OMP(parallel)
+    {
+        long from, to;
+        getThreadShare(stride, from, to);
+        for( long comp = 0; comp < comps; comp++ ){
+            fill(data+comp*stride+from, data+comp*stride+to, 0.0);
+        }
+    }
+}
+
+
+//  variables are declared with their number of components,
+//  storage is structure of arrays: one aligned array per component
+void GridManager::initFieldStorage(){
+    
+    auto start_time = high_resolution_clock::now();
+    
     int numOfSpecies = loader->getNumberOfSpecies();
+    int v, spn;
+    
+    totVarsOnG1 = SIZEG1;
+    totVarsOnG2 = NUM_OF_MAIN_G2VARS+2*numOfSpecies;
     
     #ifdef GET_ION_PRESSURE
-        nodesG2vars = new VectorVar*[G2nodesNumber*(NUM_OF_MAIN_G2VARS+3*numOfSpecies)];
-    #else
-        nodesG2vars = new VectorVar*[G2nodesNumber*(NUM_OF_MAIN_G2VARS+2*numOfSpecies)];
+        totVarsOnG2 = NUM_OF_MAIN_G2VARS+3*numOfSpecies;
     #endif
     
-    nodesG1vars = new VectorVar*[G1nodesNumber*2];
+    SHIFT_MAIN_DENS     = NUM_OF_MAIN_G2VARS;
+    SHIFT_MAIN_DENS_AUX = SHIFT_MAIN_DENS+numOfSpecies;
+    SHIFT_MAIN_ION_PRES = SHIFT_MAIN_DENS_AUX+numOfSpecies;
     
-    initG1Nodes();
-    initG2Nodes();
-
-    sendRecvIndecis4MPI();
-    sendRecvIndecis4MPIext();
-    sendRecvIndecis4MPIonG4();
+    varSizeG1.assign(totVarsOnG1, 3);
     
-    initBoundaryIndecies();
+    varSizeG2.assign(totVarsOnG2, 3);
+    varSizeG2[DENSELEC]     = 1;
+    varSizeG2[PRESSURE]     = 6;
+    varSizeG2[PRESSURE_AUX] = 6;
+    varSizeG2[PRESSURE_SMO] = 6;
+    varSizeG2[DRIVER]       = 6;
+    varSizeG2[DRIVER_AUX]   = 6;
+    varSizeG2[DRIVER_CROSS] = 6;
     
-    getVectorVariablesForAllNodes();
-    logger->writeMsg("[GridManager] initialize() ...OK", DEBUG);
+    humanG2VarNames = {"e", "eaux", "j", "jaux", "vi", "ne", "ve", "pe", "peaux",
+                       "pesmo", "pdr", "pdraux", "pdrcr", "pdrdiag", "eta"};
+    
+    for( spn = 0; spn < numOfSpecies; spn++ ){
+        varSizeG2[DENS_VEL(spn)] = 4;
+        varSizeG2[DENS_AUX(spn)] = 1;
+        humanG2VarNames.push_back("nv"+to_string(spn+1));
+    }
+    for( spn = 0; spn < numOfSpecies; spn++ ){
+        humanG2VarNames.push_back("nvaux"+to_string(spn+1));
+    }
+    #ifdef GET_ION_PRESSURE
+    for( spn = 0; spn < numOfSpecies; spn++ ){
+        varSizeG2[ION_PRESSURE(spn)] = 6;
+        humanG2VarNames.push_back("pi"+to_string(spn+1));
+    }
+    #endif
+    
+    firstCompG1.assign(totVarsOnG1, 0);
+    for( v = 1; v < totVarsOnG1; v++ ){
+        firstCompG1[v] = firstCompG1[v-1]+varSizeG1[v-1];
+    }
+    firstCompG2.assign(totVarsOnG2, 0);
+    for( v = 1; v < totVarsOnG2; v++ ){
+        firstCompG2[v] = firstCompG2[v-1]+varSizeG2[v-1];
+    }
+    long compsG1 = firstCompG1[totVarsOnG1-1]+varSizeG1[totVarsOnG1-1];
+    long compsG2 = firstCompG2[totVarsOnG2-1]+varSizeG2[totVarsOnG2-1];
+    
+    strideG1 = alignedStride(G1nodesNumber);
+    strideG2 = alignedStride(G2nodesNumber);
+    
+    //# halo slabs are described by MPI datatypes directly on this storage
+    if( loader->useSharedMemory ){
+        initSharedStorage();
+    }else{
+        fieldsG2 = allocAligned(strideG2*compsG2);
+    }
+    fieldsG1 = allocAligned(strideG1*compsG1);
+    
+    firstTouch(fieldsG1, strideG1, compsG1);
+    firstTouch(fieldsG2, strideG2, compsG2);
+    
+    firstCompDerived[0] = 0;
+    for( v = 1; v < SIZE_DERIVED; v++ ){
+        firstCompDerived[v] = firstCompDerived[v-1]+derivedSize[v-1];
+    }
+    long compsDerived = firstCompDerived[SIZE_DERIVED-1]+derivedSize[SIZE_DERIVED-1];
+    derivedFields = allocAligned(strideG2*compsDerived);
+    firstTouch(derivedFields, strideG2, compsDerived);
+    
+    auto end_time = high_resolution_clock::now();
+    string msg ="[GridManager] field storage: "+to_string(compsG1)+" components on G1, "
+                +to_string(compsG2)+" components on G2, "
+                +to_string(sizeof(double)*(strideG1*compsG1+strideG2*compsG2)/1024/1024)
+                +" MB, duration = "
+                +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    logger->writeMsg(msg.c_str(), DEBUG);
 }
 
-const int* GridManager::getNeibors4G2spatialDerX(){
-    return neibors4G2spatialDerX;
-}
 
-const int* GridManager::getNeibors4G2spatialDerY(){
-    return neibors4G2spatialDerY;
+//  node strides along x, y and z of the grid with res+extra nodes per axis,
+//  if collapse != 0 strides of the axes with resolution 1 are 0
+void GridManager::getNodeStrides(int extra, int collapse, int strides[3]){
+    
+    int n1 = loader->resolution[1]+extra;
+    int n2 = loader->resolution[2]+extra;
+    
+    strides[0] = n1*n2;
+    strides[1] = n2;
+    strides[2] = 1;
+    
+    if( collapse ){
+        for( int e = 0; e < 3; e++ ){
+            if( loader->resolution[e] == 1 ){
+                strides[e] = 0;
+            }
+        }
+    }
 }
 
-const int* GridManager::getNeibors4G2spatialDerZ(){
-    return neibors4G2spatialDerZ;
+//  grid kernels are compiled for 1, 2 and 3 dimensions: the number of
+//  leading axes after which all axes are collapsed (resolution 1)
+int GridManager::getGridDimension(){
+    if( loader->resolution[2] != 1 ){
+        return 3;
+    }
+    return loader->resolution[1] != 1 ? 2 : 1;
 }
 
 
-const int* GridManager::getNeibors4G1spatialDerX(){
-    return neibors4G1spatialDerX;
+//  tiles of the kernel sweep over nodes first <= i < res+extra along
+//  every axis, tile sizes are set in the input file
+vector<Tile> GridManager::getTiles(int first, int extra){
+    
+    int from[3], to[3];
+    
+    for( int e = 0; e < 3; e++ ){
+        from[e] = first;
+        to[e]   = loader->resolution[e]+extra;
+    }
+    return makeTiles(from, to, loader->tileSize);
 }
 
-const int* GridManager::getNeibors4G1spatialDerY(){
-    return neibors4G1spatialDerY;
+
+//  tiles of getTiles(first, extra) with the shell first: the first and the
+//  last layer along every axis with a halo neighbour, which for first = 1,
+//  extra = 1 are the G2 nodes sent to the neighbours. The inner tiles,
+//  computed while the halo of the shell is in flight, start at shellTilesNum
+vector<Tile> GridManager::getShellFirstTiles(int first, int extra, int& shellTilesNum){
+    
+    int from[3], to[3], innerFrom[3], innerTo[3], slabFrom[3], slabTo[3];
+    int shell[3] = {0, 0, 0};
+    int e, d, side, t;
+    
+    for( int n = 0; n < loader->haloNeighbors.size(); n++ ){
+        t = loader->haloNeighbors[n];
+        shell[0] |= t/9 != 1;
+        shell[1] |= (t/3)%3 != 1;
+        shell[2] |= t%3 != 1;
+    }
+    
+    for( e = 0; e < 3; e++ ){
+        from[e] = first;
+        to[e]   = loader->resolution[e]+extra;
+        innerFrom[e] = shell[e] ? from[e]+1 : from[e];
+        innerTo[e]   = shell[e] ? max(to[e]-1, innerFrom[e]) : to[e];
+    }
+    
+    //# slabs across axis e take only the inner part of the axes before e,
+    //# a single layer belongs to the first slab
+    vector<Tile> tiles, part;
+    for( e = 0; e < 3; e++ ){
+        if( !shell[e] ){
+            continue;
+        }
+        for( side = 0; side < 2; side++ ){
+            for( d = 0; d < 3; d++ ){
+                slabFrom[d] = d < e ? innerFrom[d] : from[d];
+                slabTo[d]   = d < e ? innerTo[d]   : to[d];
+            }
+            if( side == 0 ){
+                slabTo[e] = min(from[e]+1, to[e]);
+            }else{
+                slabFrom[e] = max(to[e]-1, from[e]+1);
+            }
+            part = makeTiles(slabFrom, slabTo, loader->tileSize);
+            tiles.insert(tiles.end(), part.begin(), part.end());
+        }
+    }
+    
+    shellTilesNum = tiles.size();
+    part = makeTiles(innerFrom, innerTo, loader->tileSize);
+    tiles.insert(tiles.end(), part.begin(), part.end());
+    return tiles;
 }
 
-const int* GridManager::getNeibors4G1spatialDerZ(){
-    return neibors4G1spatialDerZ;
+
+//  position of every node of the grid with res+extra nodes per axis in the
+//  sweep of the given ordering: x, y, z, tile by tile or Morton curve
+vector<int> GridManager::getNodeOrder(int extra, int ordering){
+    
+    int n[3], from[3] = {0, 0, 0};
+    for( int e = 0; e < 3; e++ ){
+        n[e] = loader->resolution[e]+extra;
+    }
+    int nodesNum = n[0]*n[1]*n[2];
+    int i, j, k, pos = 0;
+    
+    vector<int> order(nodesNum);
+    
+    switch (ordering) {
+        case CELL_ORDERING:
+            for( int idx = 0; idx < nodesNum; idx++ ){
+                order[idx] = idx;
+            }
+            break;
+            
+        case TILE_ORDERING:{
+            vector<Tile> tiles = makeTiles(from, n, loader->tileSize);
+            for( int tileNum = 0; tileNum < tiles.size(); tileNum++ ){
+                const Tile& tile = tiles[tileNum];
+                for( i = tile.from[0]; i < tile.to[0]; i++ ){
+                    for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                        for( k = tile.from[2]; k < tile.to[2]; k++ ){
+                            order[IDX(i, j, k, n[0], n[1], n[2])] = pos++;
+                        }
+                    }
+                }
+            }
+            break;
+        }
+            
+        case MORTON_ORDERING:{
+            vector<pair<unsigned long long, int>> keys(nodesNum);
+            for( i = 0; i < n[0]; i++ ){
+                for( j = 0; j < n[1]; j++ ){
+                    for( k = 0; k < n[2]; k++ ){
+                        int idx = IDX(i, j, k, n[0], n[1], n[2]);
+                        keys[idx] = make_pair(mortonKey(i, j, k), idx);
+                    }
+                }
+            }
+            sort(keys.begin(), keys.end());
+            for( pos = 0; pos < nodesNum; pos++ ){
+                order[keys[pos].second] = pos;
+            }
+            break;
+        }
+            
+        default:
+            throw runtime_error("unknown node ordering!");
+    }
+    return order;
 }
 
+void GridManager::initialize(){
+    logger->writeMsg("[GridManager] initialize() ...", DEBUG);
+    
+    int xRes = loader->resolution[0];
+    int yRes = loader->resolution[1];
+    int zRes = loader->resolution[2];
+    
+    this->totalNodeNumber = xRes*yRes*zRes;
+    
+    this->G1nodesNumber = (xRes+1)*(yRes+1)*(zRes+1);
+    this->G2nodesNumber = (xRes+2)*(yRes+2)*(zRes+2);
+
+    initFieldStorage();
+
+    initHaloRanges();
+    initHaloDatatypes();
+    
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        checkFaceExchange();
+    }
+    
+    initBoundarySlabs();
+    initSmoothGhostWidth();
+    
+    getVectorVariablesForAllNodes();
+    logger->writeMsg("[GridManager] initialize() ...OK", DEBUG);
+}
 
 int GridManager::getVarsNumOnG1(){
     return totVarsOnG1;
@@ -151,1437 +397,1534 @@ int GridManager::getVarsNumOnG1(){
  */
 
 
-void GridManager::initBoundaryIndecies(){
-    int xRes = loader->resolution[0];
-    int yRes = loader->resolution[1];
-    int zRes = loader->resolution[2];
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int i,j,k, idx2set, idx2use;
-
-    if(loader->BCtype[0] == DAMPING && xRes != 1){
+//  ghost layers of the DAMPING sides without neighbour (not for a collapsed
+//  axis) are copies of the first inner layer, ghost layer along x is
+//  a whole plane, along y n[0] lines and along z single nodes
+void GridManager::initBoundarySlabs(){
+    
+    int n[3] = {loader->resolution[0]+2,
+                loader->resolution[1]+2,
+                loader->resolution[2]+2};
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+    long plane = long(n[1])*n[2];
+    long stride[3] = {plane, n[2], 1};
+    long blockLen[3]    = {plane, n[2], 1};
+    long blocksNum[3]   = {1, n[0], long(n[0])*n[1]};
+    long blockStride[3] = {0, plane, n[2]};
+    long nodesNum[3] = {0, 0, 0};
+    
+    for( int e = 0; e < 3; e++ ){
         
-        if (loader->neighbors2Send[NEIGHBOR_LEFT] == MPI_PROC_NULL){
-            for ( j=0; j<yResG2; j++){
-                for ( k=0; k<zResG2; k++){
-                    idx2use = IDX(1,j,k, xResG2,yResG2,zResG2);
-                    idx2set = IDX(0,j,k, xResG2,yResG2,zResG2);
-                        
-                    idxs4BoundaryX2fill[idx2use] = idx2set;
-                }
-            }
+        if( loader->BCtype[e] != DAMPING || loader->resolution[e] == 1 ){
+            continue;
         }
         
-        if (loader->neighbors2Send[NEIGHBOR_RIGHT] == MPI_PROC_NULL){
-            for ( j=0; j<yResG2; j++){
-                for ( k=0; k<zResG2; k++){
-                    idx2use = IDX(xResG2-2,j,k, xResG2,yResG2,zResG2);
-                    idx2set = IDX(xResG2-1,j,k, xResG2,yResG2,zResG2);
-                    
-                    idxs4BoundaryX2fill[idx2use] = idx2set;
-                }
+        for( int side = 0; side < 2; side++ ){
+            if( loader->neighbors2Send[faces[2*e+side]] != MPI_PROC_NULL ){
+                continue;
             }
+            BoundarySlab slab;
+            slab.src = side == 0 ? stride[e] : (n[e]-2)*stride[e];
+            slab.dst = side == 0 ? 0         : (n[e]-1)*stride[e];
+            slab.blockLen    = blockLen[e];
+            slab.blocksNum   = blocksNum[e];
+            slab.blockStride = blockStride[e];
+            boundarySlabs.push_back(slab);
+            nodesNum[e] += blockLen[e]*blocksNum[e];
         }
     }
     
-    if(loader->BCtype[1] == DAMPING && yRes != 1){
+    string msg ="[GridManager] initialized boundary slabs, ghost nodes to fill along x = "
+    +to_string(nodesNum[0])
+    +"\n                       along y = "
+    +to_string(nodesNum[1])
+    +"\n                       along z = "
+    +to_string(nodesNum[2]);
+    logger->writeMsg(msg.c_str(), DEBUG);
+}
+
+
+int GridManager::getVarsNumOnG2(){
+    return totVarsOnG2;
+}
+
+
+//G2 grid describes extended grid G1
+
+int GridManager::DENS_AUX(int sp){
+    return SHIFT_MAIN_DENS_AUX+sp;
+}
+
+int GridManager::DENS_VEL(int sp){
+    return SHIFT_MAIN_DENS+sp;
+}
+
+int GridManager::ION_PRESSURE(int sp){
+    return SHIFT_MAIN_ION_PRES+sp;
+}
+
+void GridManager::applyBC(int varName){
+    //nothing for periodic BC, no slabs
+    auto start_time = high_resolution_clock::now();
+    
+    FieldG2 var = getFieldOnG2(varName);
+    int varDim = var.getSize();
+    int dim;
+    long b, n;
+    
+    for ( dim = 0; dim < varDim; dim++ ){
+        double* comp = var.getComponent(dim);
         
-        if (loader->neighbors2Send[NEIGHBOR_BOTTOM] == MPI_PROC_NULL){
-            for ( i=0; i<xResG2; i++){
-                for ( k=0; k<zResG2; k++){
-                    idx2use = IDX(i,1,k, xResG2,yResG2,zResG2);
-                    idx2set = IDX(i,0,k, xResG2,yResG2,zResG2);
-                    
-                    idxs4BoundaryY2fill[idx2use] = idx2set;
-                }
-            }
-        }
-        if (loader->neighbors2Send[NEIGHBOR_TOP] == MPI_PROC_NULL){
-            for ( i=0; i<xResG2; i++){
-                for ( k=0; k<zResG2; k++){
-                    idx2use = IDX(i,yResG2-2,k, xResG2,yResG2,zResG2);
-                    idx2set = IDX(i,yResG2-1,k, xResG2,yResG2,zResG2);
-                    
-                    idxs4BoundaryY2fill[idx2use] = idx2set;
+        for ( const auto &slab : boundarySlabs ) {
+            for ( b = 0; b < slab.blocksNum; b++ ){
+                const double* src = comp+slab.src+b*slab.blockStride;
+                double* dst       = comp+slab.dst+b*slab.blockStride;
+                for ( n = 0; n < slab.blockLen; n++ ){
+                    dst[n] = src[n];
                 }
             }
         }
     }
     
-    if(loader->BCtype[2] == DAMPING && zRes != 1){
-        
-        if (loader->neighbors2Send[NEIGHBOR_BACK] == MPI_PROC_NULL){
-            for ( i=0; i<xResG2; i++){
-                for ( j=0; j<yResG2; j++){
-                    idx2use = IDX(i,j,1, xResG2,yResG2,zResG2);
-                    idx2set = IDX(i,j,0, xResG2,yResG2,zResG2);
-                    
-                    idxs4BoundaryZ2fill[idx2use] = idx2set;
-                }
+    auto end_time = high_resolution_clock::now();
+    string msg ="[GridManager] apply the same value BC for var = "+to_string(varName) +"  duration = "
+    +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    logger->writeMsg(msg.c_str(), DEBUG);
+    
+    invalidateDerivedOnG2(varName);
+}
+
+
+
+//  slab along one axis: {send from, send to, recv from, recv to},
+//  offset = -1, 0, 1 is the direction of the neighbour along this axis
+void GridManager::getHaloSlab(int haloType, int offset, int R, int rng[4]){
+
+    int slabs[3][3][4] = {
+        {{1, 1, R + 1, R + 1}, {1, R    , 1, R    }, {R, R    , 0, 0}},  // HALO_G2
+        {{0, 1, R    , R + 1}, {0, R + 1, 0, R + 1}, {R, R + 1, 0, 1}},  // HALO_G2_GATHER
+        {{1, 1, R + 1, R + 1}, {1, R    , 1, R    }, {R, R    , 0, 0}}}; // HALO_G2_SMOOTHED
+
+    for( int n = 0; n < 4; n++ ){
+        rng[n] = slabs[haloType][offset+1][n];
+    }
+}
+
+
+/*  26-neighbour exchange: neighbour t = (1+c)+3*((1+b)+3*(1+a)).
+ *  three-stage exchange: x faces, then y faces, then z faces.
+ *  Tangential extent of a slab includes the ghost layers of the directions
+ *  exchanged in the previous stages, so edge and corner values travel
+ *  through the face neighbours. For the copy exchange those
+ *  ghost layers are taken only if the corresponding neighbour exists:
+ *  this is exactly the set of nodes filled by the 26-neighbour scheme.
+ *  After smoothing the ghosts on sides without neighbour are smoothed
+ *  on every rank, so the smoothed halo carries them in both schemes.
+ */
+void GridManager::initHaloRanges(){
+
+    int res[3] = {loader->resolution[0],
+                  loader->resolution[1],
+                  loader->resolution[2]};
+
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+
+    int haloType, face, t, d, e;
+    int offset[3];
+
+    for( haloType = 0; haloType < 3; haloType++ ){
+
+        for( t = 0; t < 27; t++ ){
+            offset[0] = t/9 - 1;
+            offset[1] = (t/3)%3 - 1;
+            offset[2] = t%3 - 1;
+            for( e = 0; e < 3; e++ ){
+                getHaloSlab(haloType, offset[e], res[e], haloRange[0][haloType][t][e]);
+                getHaloSlab(haloType, 0, res[e], haloRange[1][haloType][t][e]);
             }
         }
-        if (loader->neighbors2Send[NEIGHBOR_FRONT] == MPI_PROC_NULL){
-            for ( i=0; i<xResG2; i++){
-                for ( j=0; j<yResG2; j++){
-                    idx2use = IDX(i,j,zResG2-2, xResG2,yResG2,zResG2);
-                    idx2set = IDX(i,j,zResG2-1, xResG2,yResG2,zResG2);
-                    
-                    idxs4BoundaryZ2fill[idx2use] = idx2set;
+
+        for( face = 0; face < 6; face++ ){
+
+            t = faces[face];
+            d = face/2;
+
+            for( e = 0; e < 3; e++ ){
+                int* rng = haloRange[1][haloType][t][e];
+
+                if( e == d ){
+                    getHaloSlab(haloType, face % 2 == 0 ? -1 : 1, res[e], rng);
+
+                }else if( e < d && haloType != HALO_G2_GATHER ){
+                    if( loader->neighbors2Send[faces[2*e]] != MPI_PROC_NULL ){
+                        rng[0] = 0;
+                        rng[2] = 0;
+                    }
+                    if( loader->neighbors2Send[faces[2*e+1]] != MPI_PROC_NULL ){
+                        rng[1] = res[e]+1;
+                        rng[3] = res[e]+1;
+                    }
                 }
             }
         }
     }
-    
-    string msg ="[GridManager] initialized idxs4BoundaryX2fill.size() = "
-    +to_string(idxs4BoundaryX2fill.size())
-    +"\n                       idxs4BoundaryY2fill.size() = "
-    +to_string(idxs4BoundaryY2fill.size())
-    +"\n                       idxs4BoundaryZ2fill.size() = "
-    +to_string(idxs4BoundaryZ2fill.size());
-    logger->writeMsg(msg.c_str(), DEBUG);
-}
 
-//G1 grid describes vecticies of the cells
-void GridManager::initG1Nodes(){
-    auto start_time = high_resolution_clock::now();
-    logger->writeMsg("[GridManager] init Node on G1 start ", DEBUG);
-    int xRes = loader->resolution[0];
-    int yRes = loader->resolution[1];
-    int zRes = loader->resolution[2];
-    int xResG1 = xRes+1, yResG1 = yRes+1, zResG1 = zRes+1;
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    
-    int   dx[4][2][3] = {{{1,0,0}, {0,0,0}}, {{1,1,0}, {0,1,0}},
-                         {{1,0,1}, {0,0,1}}, {{1,1,1}, {0,1,1}}};
-    int   dy[4][2][3] = {{{0,1,0}, {0,0,0}}, {{1,1,0}, {1,0,0}},
-                         {{0,1,1}, {0,0,1}}, {{1,1,1}, {1,0,1}}};
-    int   dz[4][2][3] = {{{0,0,1}, {0,0,0}}, {{1,0,1}, {1,0,0}},
-                         {{0,1,1}, {0,1,0}}, {{1,1,1}, {1,1,0}}};
-    
-    int neibIDXs[8][3] = {{0,0,0}, {0,0,1}, {0,1,0}, {1,0,0},
-                          {0,1,1}, {1,1,0}, {1,0,1}, {1,1,1}};
-    int i,j,k,idx;
-    int idx_count = 0;
-    for( i = 0; i < xResG1; i++ ){
-        for( j = 0; j < yResG1; j++ ){
-            for( k = 0; k < zResG1; k++ ){
-                
-                idx   = IDX(i,j,k,xResG1,yResG1,zResG1);
-                
-                for( int comp = 0; comp < 8; comp++ ){
-                    neibors4G2spatialDerX[8*idx+comp] = 0;
-                    neibors4G2spatialDerY[8*idx+comp] = 0;
-                    neibors4G2spatialDerZ[8*idx+comp] = 0;
-                    neighbourhood[8*idx+comp] = idx;
-                }
+    for( int scheme = 0; scheme < 2; scheme++ ){
+        for( t = 0; t < 27; t++ ){
+            offset[0] = t/9 - 1;
+            offset[1] = (t/3)%3 - 1;
+            offset[2] = t%3 - 1;
+            for( e = 0; e < 3; e++ ){
+                int* rng = haloRange[scheme][HALO_G2_SMOOTHED][t][e];
 
-                
-                vector<int> neiborsX = {0, 0, 0, 0, 0, 0, 0, 0};
-                vector<int> neiborsY = {0, 0, 0, 0, 0, 0, 0, 0};
-                vector<int> neiborsZ = {0, 0, 0, 0, 0, 0, 0, 0};
-                    
-                for( int pairNum = 0; pairNum < 4; pairNum++ ){
-                        if(xRes != 1){
-                            neiborsX[2*pairNum+0] = IDX(i+dx[pairNum][0][0],
-                                                        j+dx[pairNum][0][1],
-                                                        k+dx[pairNum][0][2],
-                                                        xResG2,yResG2,zResG2);
-                            
-                            neiborsX[2*pairNum+1] = IDX(i+dx[pairNum][1][0],
-                                                        j+dx[pairNum][1][1],
-                                                        k+dx[pairNum][1][2],
-                                                        xResG2,yResG2,zResG2);
-                        }
-                        if(yRes != 1){
-                            neiborsY[2*pairNum+0] = IDX(i+dy[pairNum][0][0],
-                                                        j+dy[pairNum][0][1],
-                                                        k+dy[pairNum][0][2],
-                                                        xResG2,yResG2,zResG2);
-                            
-                            neiborsY[2*pairNum+1] = IDX(i+dy[pairNum][1][0],
-                                                        j+dy[pairNum][1][1],
-                                                        k+dy[pairNum][1][2],
-                                                        xResG2,yResG2,zResG2);
-                        }
-                        
-                        if(zRes != 1){
-                            neiborsZ[2*pairNum+0] = IDX(i+dz[pairNum][0][0],
-                                                        j+dz[pairNum][0][1],
-                                                        k+dz[pairNum][0][2],
-                                                        xResG2,yResG2,zResG2);
-                            
-                            neiborsZ[2*pairNum+1] = IDX(i+dz[pairNum][1][0],
-                                                        j+dz[pairNum][1][1],
-                                                        k+dz[pairNum][1][2],
-                                                        xResG2,yResG2,zResG2);
-                        }
-                        
+                if( offset[e] != 0 ){
+                    continue;
                 }
-                    
-                for( int comp = 0; comp < 8; comp++ ){
-                    neibors4G2spatialDerX[8*idx+comp] = neiborsX[comp];
-                    neibors4G2spatialDerY[8*idx+comp] = neiborsY[comp];
-                    neibors4G2spatialDerZ[8*idx+comp] = neiborsZ[comp];
+                if( loader->neighbors2Send[faces[2*e]] == MPI_PROC_NULL ){
+                    rng[0] = 0;
+                    rng[2] = 0;
                 }
-                    
-                if( i != 0 && j != 0 && k != 0 ){
-                    for(int comp = 0; comp < 8; comp++){
-                        neiborsX[comp] = 0;
-                        neiborsY[comp] = 0;
-                        neiborsZ[comp] = 0;
-                    }
-                    
-                    for( int pairNum = 0; pairNum < 4; pairNum++ ){
-                            if(xRes != 1){
-                                neiborsX[2*pairNum+0] = IDX(i-dx[pairNum][0][0],
-                                                            j-dx[pairNum][0][1],
-                                                            k-dx[pairNum][0][2],
-                                                            xResG1,yResG1,zResG1);
-                                
-                                neiborsX[2*pairNum+1] = IDX(i-dx[pairNum][1][0],
-                                                            j-dx[pairNum][1][1],
-                                                            k-dx[pairNum][1][2],
-                                                            xResG1,yResG1,zResG1);
-                            }
-                            if(yRes != 1){
-                                neiborsY[2*pairNum+0] = IDX(i-dy[pairNum][0][0],
-                                                            j-dy[pairNum][0][1],
-                                                            k-dy[pairNum][0][2],
-                                                            xResG1,yResG1,zResG1);
-                                
-                                neiborsY[2*pairNum+1] = IDX(i-dy[pairNum][1][0],
-                                                            j-dy[pairNum][1][1],
-                                                            k-dy[pairNum][1][2],
-                                                            xResG1,yResG1,zResG1);
-                            }
-                            if(zRes != 1){
-                                neiborsZ[2*pairNum+0] = IDX(i-dz[pairNum][0][0],
-                                                            j-dz[pairNum][0][1],
-                                                            k-dz[pairNum][0][2],
-                                                            xResG1,yResG1,zResG1);
-                                
-                                neiborsZ[2*pairNum+1] = IDX(i-dz[pairNum][1][0],
-                                                            j-dz[pairNum][1][1],
-                                                            k-dz[pairNum][1][2],
-                                                            xResG1,yResG1,zResG1);
-                            }
-                    }
-                        
-                    for( int comp = 0; comp < 8; comp++ ){
-                        neibors4G1spatialDerX[8*idx+comp] = neiborsX[comp];
-                        neibors4G1spatialDerY[8*idx+comp] = neiborsY[comp];
-                        neibors4G1spatialDerZ[8*idx+comp] = neiborsZ[comp];
-                    }
-                    
-                    idx_count++;
-                    
-                    int a = xRes == 1 ? 0 : 1;
-                    int b = yRes == 1 ? 0 : 1;
-                    int c = zRes == 1 ? 0 : 1;
-                    
-                    
-                    for( int neiNum = 0; neiNum < 8; neiNum++ ){
-                        neighbourhood[8*idx+neiNum] = IDX(i-a*neibIDXs[neiNum][0],
-                                                          j-b*neibIDXs[neiNum][1],
-                                                          k-c*neibIDXs[neiNum][2],
-                                                          xResG1,yResG1,zResG1);
-                    }
+                if( loader->neighbors2Send[faces[2*e+1]] == MPI_PROC_NULL ){
+                    rng[1] = res[e]+1;
+                    rng[3] = res[e]+1;
                 }
-                
-                VectorVar* mag     = new VectorVar(MAGNETIC,     {0.0, 0.0, 0.0});
-                VectorVar* mag_aux = new VectorVar(MAGNETIC_AUX, {0.0, 0.0, 0.0});
-                nodesG1vars[G1nodesNumber*MAGNETIC     + idx] = mag;
-                nodesG1vars[G1nodesNumber*MAGNETIC_AUX + idx] = mag_aux;
-                totVarsOnG1 = SIZEG1;
             }
         }
     }
-    
-   
-    
-    auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] init Node G1 OK..duration = "
-                +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
-    logger->writeMsg(msg.c_str(), DEBUG);
-}
-
-const int* GridManager::getNghbd4DivPeInXonG2(){
-    return negbors4PresX;
 }
 
-const int* GridManager::getNghbd4DivPeInYonG2(){
-    return negbors4PresY;
-}
-
-const int* GridManager::getNghbd4DivPeInZonG2(){
-    return negbors4PresZ;
-}
-
-const int* GridManager::getNghbd4LaplacInXonG2(){
-    return negbors4LaplacX;
-}
-
-const int* GridManager::getNghbd4LaplacInYonG2(){
-    return negbors4LaplacY;
-}
 
-const int* GridManager::getNghbd4LaplacInZonG2(){
-    return negbors4LaplacZ;
-}
+//  committed datatypes for every halo slab and every variable size:
+//  the slab of one component is a subarray, components are stride apart
+void GridManager::initHaloDatatypes(){
 
+    auto start_time = high_resolution_clock::now();
 
-int GridManager::getVarsNumOnG2(){
-    return totVarsOnG2;
-}
+    int res[3] = {loader->resolution[0],
+                  loader->resolution[1],
+                  loader->resolution[2]};
 
+    int schemesNum = loader->haloExchangeType == FACE_STAGED_EXCHANGE ? 2 : 1;
+    int scheme, haloType, n, t, e, side, varDim;
+    int sizes[3], subsizes[3], starts[3];
 
-//G2 grid describes extended grid G1
-void GridManager::initG2Nodes(){
-    auto start_time = high_resolution_clock::now();
-    logger->writeMsg("[GridManager] init Node start ", DEBUG);
-    int xRes = loader->resolution[0], yRes = loader->resolution[1], zRes = loader->resolution[2];
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-//                                    +          -
-    int PAIRS4divPinX[9][2][3] = { {{ 1, 1,-1},{-1, 1,-1}},
-                                   {{ 1,-1,-1},{-1,-1,-1}}, // weight  = 0.125
-                                   {{ 1, 1, 1},{-1, 1, 1}},
-                                   {{ 1,-1, 1},{-1,-1, 1}},
-        
-                                   {{ 1, 0,-1},{-1, 0,-1}},
-                                   {{ 1, 1, 0},{-1, 1, 0}}, // weight  = 0.25
-                                   {{ 1,-1, 0},{-1,-1, 0}},
-                                   {{ 1, 0, 1},{-1, 0, 1}},
-        
-                                   {{ 1, 0, 0},{-1, 0, 0}}};// weight  = 0.5
-//                                       +          -
-    int PAIRS4divPinY[9][2][3] = { {{ 1, 1,-1},{ 1,-1,-1}},
-                                   {{-1, 1,-1},{-1,-1,-1}},
-                                   {{ 1, 1, 1},{ 1,-1, 1}},
-                                   {{-1, 1, 1},{-1,-1, 1}},
-        
-                                   {{ 0, 1,-1},{ 0,-1,-1}},
-                                   {{ 1, 1, 0},{ 1,-1, 0}},
-                                   {{-1, 1, 0},{-1,-1, 0}},
-                                   {{ 0, 1, 1},{ 0,-1, 1}},
-        
-                                   {{ 0, 1, 0},{ 0,-1, 0}}};
-//                                          +          -
-    int PAIRS4divPinZ[9][2][3] = { {{ 1,-1, 1},{ 1,-1,-1}},
-                                   {{-1,-1, 1},{-1,-1,-1}},
-                                   {{ 1, 1, 1},{ 1, 1,-1}},
-                                   {{-1, 1, 1},{-1, 1,-1}},
-       
-                                   {{ 0,-1, 1},{ 0,-1,-1}},
-                                   {{ 1, 0, 1},{ 1, 0,-1}},
-                                   {{-1, 0, 1},{-1, 0,-1}},
-                                   {{ 0, 1, 1},{ 0, 1,-1}},
-        
-                                   {{ 0, 0, 1},{ 0, 0,-1}}};
-    
-    int PAIRS4LapJinX[2][2][3] = {{{1,0,0}, {0,0,0}}, {{-1,0,0}, {0,0,0}}};
-    int PAIRS4LapJinY[2][2][3] = {{{0,1,0}, {0,0,0}}, {{0,-1,0}, {0,0,0}}};
-    int PAIRS4LapJinZ[2][2][3] = {{{0,0,1}, {0,0,0}}, {{0,0,-1}, {0,0,0}}};
+    MPI_Datatype compType;
+    MPI_Datatype* slabType;
 
-    int numOfSpecies = loader->getNumberOfSpecies();
+    for( scheme = 0; scheme < schemesNum; scheme++ ){
 
-    int i,j,k,idx, idxG1;
-    for ( i=0; i<xResG2; i++){
-        for ( j=0; j<yResG2; j++){
-            for ( k=0; k<zResG2; k++){
-                idx = IDX(i,j,k,xResG2,yResG2,zResG2);
-                
-                vector<int> neibors4divPX(18);
-                vector<int> neibors4divPY(18);
-                vector<int> neibors4divPZ(18);
-                
-                for(int comp = 0; comp < 18; comp++){
-                     negbors4PresX[18*idx+comp] = 0;
-                     negbors4PresY[18*idx+comp] = 0;
-                     negbors4PresZ[18*idx+comp] = 0;
-                }
-                
-                vector<int> neibors4LapX(4);
-                vector<int> neibors4LapY(4);
-                vector<int> neibors4LapZ(4);
-                
-                for(int comp = 0; comp < 4; comp++){
-                    negbors4LaplacX[4*idx+comp] = 0;
-                    negbors4LaplacY[4*idx+comp] = 0;
-                    negbors4LaplacZ[4*idx+comp] = 0;
-                }
-                
-                if(i != 0 && j != 0 && k != 0 && i != xResG2-1
-                          && j != yResG2-1 && k != zResG2-1){
-                    
-                    for(int pairNum = 0; pairNum<9; pairNum++){
-                        if(xRes != 1){
-                            neibors4divPX[2*pairNum+0] = IDX(i+PAIRS4divPinX[pairNum][0][0],
-                                                             j+PAIRS4divPinX[pairNum][0][1],
-                                                             k+PAIRS4divPinX[pairNum][0][2],
-                                                             xResG2,yResG2,zResG2);
-                            
-                            neibors4divPX[2*pairNum+1] = IDX(i+PAIRS4divPinX[pairNum][1][0],
-                                                             j+PAIRS4divPinX[pairNum][1][1],
-                                                             k+PAIRS4divPinX[pairNum][1][2],
-                                                             xResG2,yResG2,zResG2);
-                        }
-                        if(yRes != 1){
-                            neibors4divPY[2*pairNum+0] = IDX(i+PAIRS4divPinY[pairNum][0][0],
-                                                             j+PAIRS4divPinY[pairNum][0][1],
-                                                             k+PAIRS4divPinY[pairNum][0][2],
-                                                             xResG2,yResG2,zResG2);
-                            
-                            neibors4divPY[2*pairNum+1] = IDX(i+PAIRS4divPinY[pairNum][1][0],
-                                                             j+PAIRS4divPinY[pairNum][1][1],
-                                                             k+PAIRS4divPinY[pairNum][1][2],
-                                                             xResG2,yResG2,zResG2);
-                        }
-                        if(zRes != 1){
-                            neibors4divPZ[2*pairNum+0] = IDX(i+PAIRS4divPinZ[pairNum][0][0],
-                                                             j+PAIRS4divPinZ[pairNum][0][1],
-                                                             k+PAIRS4divPinZ[pairNum][0][2],
-                                                             xResG2,yResG2,zResG2);
-                        
-                            neibors4divPZ[2*pairNum+1] = IDX(i+PAIRS4divPinZ[pairNum][1][0],
-                                                             j+PAIRS4divPinZ[pairNum][1][1],
-                                                             k+PAIRS4divPinZ[pairNum][1][2],
-                                                             xResG2,yResG2,zResG2);
-                        }
-                        
-                    }
-                    
-                    for(int comp = 0; comp < 18; comp++){
-                        negbors4PresX[18*idx+comp] = neibors4divPX[comp];
-                        negbors4PresY[18*idx+comp] = neibors4divPY[comp];
-                        negbors4PresZ[18*idx+comp] = neibors4divPZ[comp];
-                    }
-                    
-                    for(int pairNum = 0; pairNum<2; pairNum++){
-                        if(xRes != 1){
-                            neibors4LapX[2*pairNum+0] = IDX(i+PAIRS4LapJinX[pairNum][0][0],
-                                                            j+PAIRS4LapJinX[pairNum][0][1],
-                                                            k+PAIRS4LapJinX[pairNum][0][2],
-                                                            xResG2,yResG2,zResG2);
-                            
-                            neibors4LapX[2*pairNum+1] = IDX(i+PAIRS4LapJinX[pairNum][1][0],
-                                                            j+PAIRS4LapJinX[pairNum][1][1],
-                                                            k+PAIRS4LapJinX[pairNum][1][2],
-                                                            xResG2,yResG2,zResG2);
-                        }
-                        if(yRes != 1){
-                            neibors4LapY[2*pairNum+0] = IDX(i+PAIRS4LapJinY[pairNum][0][0],
-                                                            j+PAIRS4LapJinY[pairNum][0][1],
-                                                            k+PAIRS4LapJinY[pairNum][0][2],
-                                                            xResG2,yResG2,zResG2);
-                            
-                            neibors4LapY[2*pairNum+1] = IDX(i+PAIRS4LapJinY[pairNum][1][0],
-                                                            j+PAIRS4LapJinY[pairNum][1][1],
-                                                            k+PAIRS4LapJinY[pairNum][1][2],
-                                                            xResG2,yResG2,zResG2);
-                        }
-                        if(zRes != 1){
-                            neibors4LapZ[2*pairNum+0] = IDX(i+PAIRS4LapJinZ[pairNum][0][0],
-                                                            j+PAIRS4LapJinZ[pairNum][0][1],
-                                                            k+PAIRS4LapJinZ[pairNum][0][2],
-                                                            xResG2,yResG2,zResG2);
-                            
-                            neibors4LapZ[2*pairNum+1] = IDX(i+PAIRS4LapJinZ[pairNum][1][0],
-                                                            j+PAIRS4LapJinZ[pairNum][1][1],
-                                                            k+PAIRS4LapJinZ[pairNum][1][2],
-                                                            xResG2,yResG2,zResG2);
-                        }
+        vector<int> neighbors = getNeighbors4Stage(ALL_NEIGHBORS);
+        if( scheme == 1 ){
+            neighbors = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                         NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                         NEIGHBOR_BACK, NEIGHBOR_FRONT};
+        }
+
+        for( haloType = 0; haloType < 3; haloType++ ){
+
+            for( n = 0; n < neighbors.size(); n++ ){
+                t = neighbors[n];
+
+                for( side = 0; side < 2; side++ ){
+
+                    //# gathered slabs are received into a buffer
+                    if( side == 1 && haloType == HALO_G2_GATHER ){
+                        continue;
                     }
-                    
-                    for(int comp = 0; comp < 4; comp++){
-                        negbors4LaplacX[4*idx+comp] = neibors4LapX[comp];
-                        negbors4LaplacY[4*idx+comp] = neibors4LapY[comp];
-                        negbors4LaplacZ[4*idx+comp] = neibors4LapZ[comp];
+
+                    for( e = 0; e < 3; e++ ){
+                        int* rng = haloRange[scheme][haloType][t][e];
+                        sizes[e]    = res[e]+2;
+                        starts[e]   = rng[2*side];
+                        subsizes[e] = rng[2*side+1] - rng[2*side] + 1;
                     }
 
-                }
-                
-                
-                VectorVar* ele         = new VectorVar(ELECTRIC,      {0.0, 0.0, 0.0});
-                VectorVar* ele_aux     = new VectorVar(ELECTRIC_AUX,  {0.0, 0.0, 0.0});
-                VectorVar* current     = new VectorVar(CURRENT,       {0.0, 0.0, 0.0});
-                VectorVar* current_aux = new VectorVar(CURRENT_AUX,   {0.0, 0.0, 0.0});
-                VectorVar* veloion     = new VectorVar(VELOCION,      {0.0, 0.0, 0.0});
-                VectorVar* densele     = new VectorVar(DENSELEC,      {0.0});
-                VectorVar* veloele     = new VectorVar(VELOCELE,      {0.0, 0.0, 0.0});
-                VectorVar* presure     = new VectorVar(PRESSURE,      {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                VectorVar* presure_aux = new VectorVar(PRESSURE_AUX,  {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                VectorVar* presure_smo = new VectorVar(PRESSURE_SMO,  {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                VectorVar* pdriver     = new VectorVar(DRIVER,        {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                VectorVar* pdriver_aux = new VectorVar(DRIVER_AUX,    {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                VectorVar* driver_cross = new VectorVar(DRIVER_CROSS, {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                VectorVar* driver_diag = new VectorVar(DRIVER_DIAG,   {0.0, 0.0, 0.0});
-                VectorVar* resistivity = new VectorVar(RESISTIVITY,   {0.0, 0.0, 0.0});
-                                
-
-                totVarsOnG2 = NUM_OF_MAIN_G2VARS+2*numOfSpecies;
+                    MPI_Type_create_subarray(3, sizes, subsizes, starts, MPI_ORDER_C,
+                                             MPI_DOUBLE, &compType);
 
-                #ifdef GET_ION_PRESSURE
-                totVarsOnG2 = NUM_OF_MAIN_G2VARS+3*numOfSpecies;
-                #endif
-                
-                nodesG2vars[G2nodesNumber*ELECTRIC+    idx] = ele; humanG2VarNames.push_back("e");
-                nodesG2vars[G2nodesNumber*ELECTRIC_AUX+idx] = ele_aux; humanG2VarNames.push_back("eaux");
-                nodesG2vars[G2nodesNumber*CURRENT     +idx] = current; humanG2VarNames.push_back("j");
-                nodesG2vars[G2nodesNumber*CURRENT_AUX +idx] = current_aux; humanG2VarNames.push_back("jaux");
-                nodesG2vars[G2nodesNumber*VELOCION    +idx] = veloion; humanG2VarNames.push_back("vi");
-                nodesG2vars[G2nodesNumber*DENSELEC    +idx] = densele; humanG2VarNames.push_back("ne");
-                nodesG2vars[G2nodesNumber*VELOCELE    +idx] = veloele; humanG2VarNames.push_back("ve");
-                nodesG2vars[G2nodesNumber*PRESSURE    +idx] = presure; humanG2VarNames.push_back("pe");
-                nodesG2vars[G2nodesNumber*PRESSURE_AUX+idx] = presure_aux; humanG2VarNames.push_back("peaux");
-                nodesG2vars[G2nodesNumber*PRESSURE_SMO+idx] = presure_smo; humanG2VarNames.push_back("pesmo");
-                nodesG2vars[G2nodesNumber*DRIVER      +idx] = pdriver; humanG2VarNames.push_back("pdr");
-                nodesG2vars[G2nodesNumber*DRIVER_AUX  +idx] = pdriver_aux; humanG2VarNames.push_back("pdraux");
-                nodesG2vars[G2nodesNumber*DRIVER_CROSS+idx] = driver_cross; humanG2VarNames.push_back("pdrcr");
-                nodesG2vars[G2nodesNumber*DRIVER_DIAG +idx] = driver_diag; humanG2VarNames.push_back("pdrdiag");
-                nodesG2vars[G2nodesNumber*RESISTIVITY +idx] = resistivity; humanG2VarNames.push_back("eta");
-                              
-                
-                SHIFT_MAIN_DENS = NUM_OF_MAIN_G2VARS;
-                SHIFT_MAIN_DENS_AUX  = SHIFT_MAIN_DENS+numOfSpecies;
-                
-                for( int spn = 0; spn < numOfSpecies; spn++ ){
-                    VectorVar* densvel = new VectorVar(DENS_VEL(spn), {0.0, 0.0, 0.0, 0.0});
-                    VectorVar* densaux = new VectorVar(DENS_AUX(spn), {0.0});
-                    
-                    nodesG2vars[G2nodesNumber*(SHIFT_MAIN_DENS    +spn)+idx] = densvel; 
-                    nodesG2vars[G2nodesNumber*(SHIFT_MAIN_DENS_AUX+spn)+idx] = densaux; 
-                }
-		        for( int spn = 0; spn < numOfSpecies; spn++ ){
-			         humanG2VarNames.push_back("nv"+to_string(spn+1));
-		        }
-		        for( int spn = 0; spn < numOfSpecies; spn++ ){
-			         humanG2VarNames.push_back("nvaux"+to_string(spn+1));
-		        }
+                    for( varDim = 1; varDim <= MAX_VAR_DIM; varDim++ ){
+                        slabType = side == 0 ? &haloSendType[scheme][haloType][t][varDim]
+                                             : &haloRecvType[scheme][haloType][t][varDim];
 
-                #ifdef GET_ION_PRESSURE
-                SHIFT_MAIN_ION_PRES  = SHIFT_MAIN_DENS_AUX+numOfSpecies;
-                for( int spn = 0; spn < numOfSpecies; spn++ ){
-                    VectorVar* ionpresure = new VectorVar(ION_PRESSURE(spn), {0.0, 0.0, 0.0, 0.0, 0.0, 0.0});
-                    nodesG2vars[G2nodesNumber*(SHIFT_MAIN_ION_PRES+spn)+idx] = ionpresure; humanG2VarNames.push_back("pi"+to_string(spn+1));
+                        MPI_Type_create_hvector(varDim, 1, sizeof(double)*strideG2,
+                                                compType, slabType);
+                        MPI_Type_commit(slabType);
+                        haloTypes.push_back(*slabType);
+                    }
+                    MPI_Type_free(&compType);
                 }
-                #endif
             }
         }
     }
-    
+
     auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] init Node G2 duration = "
+    string msg ="[GridManager] committed "+to_string(haloTypes.size())
+                +" halo datatypes, duration = "
                 +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
     logger->writeMsg(msg.c_str(), DEBUG);
 }
 
-int GridManager::DENS_AUX(int sp){
-    return SHIFT_MAIN_DENS_AUX+sp;
-}
 
-int GridManager::DENS_VEL(int sp){
-    return SHIFT_MAIN_DENS+sp;
+void GridManager::sendBoundary2Neighbor(int varName){
+    vector<int> varNames = {varName};
+    sendBoundary2Neighbor(varNames);
 }
 
-int GridManager::ION_PRESSURE(int sp){
-    return SHIFT_MAIN_ION_PRES+sp;
-}
 
-void GridManager::applyBC(int varName){
-    //nothing for periodic BC, maps are empty
+// all listed variables are packed into one message per neighbour
+void GridManager::sendBoundary2Neighbor(vector<int> varNames){
+    
     auto start_time = high_resolution_clock::now();
+    string varsStr = "";
     
-    int varDim = nodesG2vars[G2nodesNumber*varName]->getSize();
-    int varShift = G2nodesNumber*varName;
-    int dim;
-    const double * vectorVar;
+    for( int v = 0; v < varNames.size(); v++ ){
+        varsStr += to_string(varNames[v])+" ";
+    }
     
-    for ( const auto &keyval : idxs4BoundaryX2fill ) {
-        vectorVar = nodesG2vars[varShift+keyval.first]->getValue();
-        for ( dim = 0; dim < varDim; dim++ ){
-            nodesG2vars[varShift+keyval.second]->setValue( dim, vectorVar[dim]);
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        for( int stage = 0; stage < 3; stage++ ){
+            sendRecvOnG2(varNames, HALO_G2, stage, nullptr);
         }
+    }else{
+        sendRecvOnG2(varNames, HALO_G2, ALL_NEIGHBORS, nullptr);
+    }
+    
+    auto end_time = high_resolution_clock::now();
+    string msg ="[GridManager] send boundary for vars = "+varsStr
+                +" duration = "
+                +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    logger->writeMsg(msg.c_str(), DEBUG);
+}
+
+
+//  copy halo started with non-blocking messages: the sent slabs (G2 layers
+//  1 and res) must be final, the other nodes may be written until
+//  finishBoundary2Neighbor. The three-stage exchange forwards received
+//  ghosts to the next stage, so it is done entirely at the finish
+void GridManager::startBoundary2Neighbor(vector<int> varNames){
+    
+    if( !haloVarsInFlight.empty() ){
+        throw runtime_error("halo is already in flight!");
+    }
+    
+    haloVarsInFlight = varNames;
+    haloStartTime = high_resolution_clock::now();
+    
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        return;
     }
     
-    for ( const auto &keyval : idxs4BoundaryY2fill ) {
-        vectorVar = nodesG2vars[varShift+keyval.first]->getValue();
-        for ( dim = 0; dim < varDim; dim++ ){
-            nodesG2vars[varShift+keyval.second]->setValue( dim, vectorVar[dim]);
+    vector<int> neighbors = getNeighbors4Stage(ALL_NEIGHBORS);
+    int sendTo, recvFrom, t;
+    MPI_Datatype slabsType;
+    MPI_Request request;
+    
+    for( int n = 0; n < neighbors.size(); n++ ){
+        t = neighbors[n];
+        
+        //# on-node neighbours read the slab themselves at the finish
+        sendTo   = loader->nodeNeighbors2Send[t] == MPI_PROC_NULL
+                 ? loader->neighbors2Send[t] : MPI_PROC_NULL;
+        recvFrom = loader->nodeNeighbors2Recv[t] == MPI_PROC_NULL
+                 ? loader->neighbors2Recv[t] : MPI_PROC_NULL;
+        
+        //# a datatype freed after posting stays valid for the message
+        if( recvFrom != MPI_PROC_NULL ){
+            slabsType = createSlabsType(varNames, haloRecvType[0][HALO_G2], t);
+            MPI_Irecv(MPI_BOTTOM, 1, slabsType, recvFrom, t, MPI_COMM_WORLD, &request);
+            haloRequests.push_back(request);
+            MPI_Type_free(&slabsType);
+        }
+        
+        if( sendTo != MPI_PROC_NULL ){
+            slabsType = createSlabsType(varNames, haloSendType[0][HALO_G2], t);
+            MPI_Isend(MPI_BOTTOM, 1, slabsType, sendTo, t, MPI_COMM_WORLD, &request);
+            haloRequests.push_back(request);
+            MPI_Type_free(&slabsType);
         }
     }
+}
+
+
+//  completes the halo of startBoundary2Neighbor, or does the whole
+//  exchange if it was not started (no inner nodes to compute meanwhile)
+void GridManager::finishBoundary2Neighbor(vector<int> varNames){
+    
+    if( haloVarsInFlight != varNames ){
+        startBoundary2Neighbor(varNames);
+    }
     
-    for ( const auto &keyval : idxs4BoundaryZ2fill ) {
-        vectorVar = nodesG2vars[varShift+keyval.first]->getValue();
-        for ( dim = 0; dim < varDim; dim++ ){
-            nodesG2vars[varShift+keyval.second]->setValue( dim, vectorVar[dim]);
+    auto wait_start = high_resolution_clock::now();
+    
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        for( int stage = 0; stage < 3; stage++ ){
+            sendRecvOnG2(varNames, HALO_G2, stage, nullptr);
+        }
+        //# nothing was in flight
+        haloStartTime = wait_start;
+    }else{
+        if( !haloRequests.empty() ){
+            MPI_Waitall(haloRequests.size(), &haloRequests[0], MPI_STATUSES_IGNORE);
+            haloRequests.clear();
+        }
+        
+        if( nodeWin != MPI_WIN_NULL ){
+            MPI_Win_fence(0, nodeWin);
+            vector<int> neighbors = getNeighbors4Stage(ALL_NEIGHBORS);
+            for( int n = 0; n < neighbors.size(); n++ ){
+                if( nodeNeighborStore[neighbors[n]] != nullptr ){
+                    readNodeNeighbor(varNames, HALO_G2, 0, neighbors[n], nullptr);
+                }
+            }
+            MPI_Win_fence(0, nodeWin);
         }
     }
+    haloVarsInFlight.clear();
     
     auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] apply the same value BC for var = "+to_string(varName) +"  duration = "
-    +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
-    logger->writeMsg(msg.c_str(), DEBUG);
+    double overlap = duration_cast<microseconds>(wait_start - haloStartTime).count()*1e-3;
+    double wait    = duration_cast<microseconds>(end_time - wait_start).count()*1e-3;
+    haloOverlapTime += overlap;
+    haloWaitTime    += wait;
     
+    string msg ="[GridManager] halo in flight during "+to_string(overlap)
+                +" ms of compute, waited "+to_string(wait)+" ms";
+    logger->writeMsg(msg.c_str(), DEBUG);
 }
 
 
+//  totals over the run (ms) of the compute overlapped with halos in
+//  flight and of the remaining wait for them
+double GridManager::getHaloOverlapTime(){
+    return haloOverlapTime;
+}
 
-void GridManager::sendRecvIndecis4MPI(){
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int idx, i, j, k, a, b, c, t;
-    vector<int> idxX, idxY, idxZ;
-    
-    for (a = -1; a <= 1; a++) {
-        for (b = -1; b <= 1; b++) {
-            for (c = -1; c <= 1; c++) {
-                t = (1 + c) + 3 * ((1 + b) + 3 * (1 + a));
-
-                switch (a) {
-                    case -1: idxX = {1   , 1   , xRes + 1, xRes + 1}; break;
-                    case  0: idxX = {1   , xRes, 1       , xRes    }; break;
-                    case  1: idxX = {xRes, xRes, 0       , 0       }; break;
-                }
-                switch (b) {
-                    case -1: idxY = {1   , 1   , yRes + 1, yRes + 1}; break;
-                    case  0: idxY = {1   , yRes, 1       , yRes    }; break;
-                    case  1: idxY = {yRes, yRes, 0       , 0       }; break;
-                }
-                switch (c) {
-                    case -1: idxZ = {1   , 1   , zRes + 1, zRes + 1}; break;
-                    case  0: idxZ = {1   , zRes, 1       , zRes    }; break;
-                    case  1: idxZ = {zRes, zRes, 0       , 0       }; break;
-                }
-                
-                counter[t] = (idxX[1] - idxX[0] + 1)*
-                             (idxY[1] - idxY[0] + 1)*
-                             (idxZ[1] - idxZ[0] + 1);
-                sendIdx[t] = new int[counter[t]];
-                recvIdx[t] = new int[counter[t]];
-                
-                int lineIDX = 0;
-                for (i = idxX[0]; i <= idxX[1]; i++) {
-                    for (j = idxY[0]; j <= idxY[1]; j++) {
-                        for (k = idxZ[0]; k <= idxZ[1]; k++) {
-                            idx = IDX(i,j,k, xResG2, yResG2, zResG2);
-                            sendIdx[t][lineIDX] = idx;
-                            lineIDX++;
-                        }
-                    }
-                }
 
-                lineIDX = 0;
-                for (i = idxX[2]; i <= idxX[3]; i++) {
-                    for (j = idxY[2]; j <= idxY[3]; j++) {
-                        for (k = idxZ[2]; k <= idxZ[3]; k++) {
-                            idx = IDX(i,j,k, xResG2, yResG2, zResG2);
-                            recvIdx[t][lineIDX] = idx;
-                            lineIDX++;
-                        }
-                    }
-                }
-            }
-        }
+double GridManager::getHaloWaitTime(){
+    return haloWaitTime;
+}
+
+
+//  struct of the slab types of all listed variables for neighbour t,
+//  addressed from MPI_BOTTOM
+MPI_Datatype GridManager::createSlabsType(const vector<int>& varNames,
+                                          MPI_Datatype slabTypes[27][MAX_VAR_DIM+1], int t){
+    
+    int varsNum = varNames.size();
+    WorkspaceScope scope(*workspace);
+    int* blocks = scope.borrow<int>(varsNum);
+    MPI_Aint* disps = scope.borrow<MPI_Aint>(varsNum);
+    MPI_Datatype* types = scope.borrow<MPI_Datatype>(varsNum);
+    fill(blocks, blocks+varsNum, 1);
+    MPI_Datatype slabsType;
+    
+    for( int v = 0; v < varsNum; v++ ){
+        MPI_Get_address(getFieldOnG2(varNames[v]).getData(), &disps[v]);
+        types[v] = slabTypes[t][varSizeG2[varNames[v]]];
     }
+    MPI_Type_create_struct(varsNum, &blocks[0], &disps[0], &types[0], &slabsType);
+    MPI_Type_commit(&slabsType);
+    
+    return slabsType;
 }
 
 
-void GridManager::sendBoundary2Neighbor(int varName){
+//  copy halo of a variable that is not read before the next communication
+//  round: it is exchanged there together with other posted halos (and
+//  migrating particles), then BC and, if asked, smoothing are applied
+void GridManager::postBoundary2Neighbor(int varName, int smoothAfter){
+    pendingHaloVars.push_back(varName);
+    pendingHaloSmooth.push_back(smoothAfter);
+}
+
+
+int GridManager::getPendingHalosNum(){
+    return pendingHaloVars.size();
+}
+
+
+bool GridManager::isHaloPending(int varName){
+    return find(pendingHaloVars.begin(), pendingHaloVars.end(), varName) != pendingHaloVars.end();
+}
+
+
+int GridManager::getCommRoundsSaved(){
+    return commRoundsSaved;
+}
+
+
+//  one round for all posted halos; payload (particle migration) joins
+//  the round only with the 26-neighbour exchange
+void GridManager::flushHalos(HaloPayload* payload){
+    
+    if( pendingHaloVars.empty() ){
+        return;
+    }
     
     auto start_time = high_resolution_clock::now();
-    int varShift = G2nodesNumber*varName;
-    int varDim = nodesG2vars[varShift]->getSize();
-    int t, i;
-    double *sendBuf[27];
-    double *recvBuf[27];
-    const double* vectorVar;
     
-    for( t = 0; t < 27; t++ ){
-        sendBuf[t] = new double[counter[t]*varDim*sizeof(double)];
-        recvBuf[t] = new double[counter[t]*varDim*sizeof(double)];
-        for( i = 0; i < counter[t]; i++ ){
-            vectorVar = nodesG2vars[varShift+sendIdx[t][i]]->getValue();
-            for( int dim = 0; dim < varDim; dim++ ){
-                sendBuf[t][varDim*i+dim] = vectorVar[dim];
-            }
-        }
+    if( payload != nullptr && loader->haloExchangeType != ALL_NEIGHBORS_EXCHANGE ){
+        throw runtime_error("payload needs the 26-neighbour halo exchange!");
     }
     
-    MPI_Status st;
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 ){
-            MPI_Sendrecv(sendBuf[t], counter[t]*varDim, MPI_DOUBLE, loader->neighbors2Send[t], t,
-                         recvBuf[t], counter[t]*varDim, MPI_DOUBLE, loader->neighbors2Recv[t], t,
-                         MPI_COMM_WORLD, &st);
+    int exchangesNum = pendingHaloVars.size() + (payload == nullptr ? 0 : 1);
+    
+    vector<int> varNames;
+    for( int v = 0; v < pendingHaloVars.size(); v++ ){
+        if( find(varNames.begin(), varNames.end(), pendingHaloVars[v]) == varNames.end() ){
+            varNames.push_back(pendingHaloVars[v]);
         }
     }
     
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 && loader->neighbors2Recv[t] != MPI_PROC_NULL ){
-            for( i = 0; i < counter[t]; i++ ){
-                for( int dim = 0; dim < varDim; dim++ ){
-                    nodesG2vars[varShift+recvIdx[t][i]]
-                    ->setValue( dim, recvBuf[t][varDim*i+dim]);
-                }
-            }
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        for( int stage = 0; stage < 3; stage++ ){
+            sendRecvOnG2(varNames, HALO_G2, stage, nullptr);
         }
+    }else{
+        sendRecvOnG2(varNames, HALO_G2, ALL_NEIGHBORS, payload);
     }
     
+    //# smoothing exchanges halos and may post nothing, so the lists
+    //# are cleared before it
+    vector<int> vars   = pendingHaloVars;
+    vector<int> smooth = pendingHaloSmooth;
+    pendingHaloVars.clear();
+    pendingHaloSmooth.clear();
+    
+    vector<int> vars2smooth;
+    for( int v = 0; v < vars.size(); v++ ){
+        applyBC(vars[v]);
+        if( smooth[v] ){
+            vars2smooth.push_back(vars[v]);
+        }
+    }
     
-    for( t = 0; t < 27; t++ ){
-        delete [] sendBuf[t];
-        delete [] recvBuf[t];
+    if( !vars2smooth.empty() ){
+        this->smooth(vars2smooth);
+        for( int v = 0; v < vars2smooth.size(); v++ ){
+            applyBC(vars2smooth[v]);
+        }
     }
     
+    commRoundsSaved += exchangesNum-1;
+    
     auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] send boundary for var = "+to_string(varName)
-                +" duration = "
+    string msg ="[GridManager] communication round for "+to_string(exchangesNum)
+                +" exchanges, rounds saved = "+to_string(exchangesNum-1)
+                +" (total "+to_string(commRoundsSaved)+")  duration = "
                 +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
     logger->writeMsg(msg.c_str(), DEBUG);
 }
 
 
+//  stage = ALL_NEIGHBORS : one message to each of (up to 26) neighbours
+//  stage = 0, 1, 2       : two face messages along x, y or z
+//  slabs of all listed variables are sent straight from the node storage:
+//  one struct datatype per neighbour combines the committed slab types
+//  payload: data of another exchange appended to the message of a copy halo
+void GridManager::sendRecvOnG2(const vector<int>& varNames, int haloType, int stage,
+                               HaloPayload* payload){
+
+    int scheme = stage == ALL_NEIGHBORS ? 0 : 1;
+    int varsNum = varNames.size();
+    int typesNum = payload == nullptr ? varsNum : varsNum+1;
+    int varDim, totDim = 0, shift;
+    int n, t, v, i, j, k, idx, pos, dim;
+    int cnt[27];
+    double *recvBuf[27];
 
-void GridManager::sendRecvIndecis4MPIext(){
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int idx, i, j, k, a, b, c, t;
-    vector<int> idxX, idxY, idxZ;
-    
-    for( a = -1; a <= 1; a++ ){
-        for( b = -1; b <= 1; b++ ){
-            for( c = -1; c <= 1; c++ ){
-                
-                t = (1 + c) + 3 * ((1 + b) + 3 * (1 + a));
+    WorkspaceScope scope(*workspace);
+    int* blocks = scope.borrow<int>(typesNum);
+    MPI_Aint* disps = scope.borrow<MPI_Aint>(typesNum);
+    MPI_Datatype* types = scope.borrow<MPI_Datatype>(typesNum);
+    fill(blocks, blocks+typesNum, 1);
+    MPI_Datatype sendType, recvType;
+    MPI_Status st;
 
-                switch (a) {
-                    case -1: idxX = {0   , 1       , xRes, xRes + 1}; break;
-                    case  0: idxX = {0   , xRes + 1, 0   , xRes + 1}; break;
-                    case  1: idxX = {xRes, xRes + 1, 0   , 1       }; break;
-                }
-                switch (b) {
-                    case -1: idxY = {0   , 1       , yRes, yRes + 1}; break;
-                    case  0: idxY = {0   , yRes + 1, 0   , yRes + 1}; break;
-                    case  1: idxY = {yRes, yRes + 1, 0   , 1       }; break;
-                }
-                switch (c) {
-                    case -1: idxZ = {0   , 1       , zRes, zRes + 1}; break;
-                    case  0: idxZ = {0   , zRes + 1, 0   , zRes + 1}; break;
-                    case  1: idxZ = {zRes, zRes + 1, 0   , 1       }; break;
+    vector<int> neighbors = getNeighbors4Stage(stage);
+    int neighborsNum = neighbors.size();
+    int sendTo, recvFrom;
+
+    for( v = 0; v < varsNum; v++ ){
+        MPI_Get_address(getFieldOnG2(varNames[v]).getData(), &disps[v]);
+        totDim += varSizeG2[varNames[v]];
+    }
+
+    //# on-node neighbours have finished writing their slabs
+    if( nodeWin != MPI_WIN_NULL ){
+        MPI_Win_fence(0, nodeWin);
+    }
+
+    for( n = 0; n < neighborsNum; n++ ){
+        t = neighbors[n];
+        int (*rng)[4] = haloRange[scheme][haloType][t];
+        
+        //# on-node neighbours read the slab themselves
+        sendTo   = loader->nodeNeighbors2Send[t] == MPI_PROC_NULL
+                 ? loader->neighbors2Send[t] : MPI_PROC_NULL;
+        recvFrom = loader->nodeNeighbors2Recv[t] == MPI_PROC_NULL
+                 ? loader->neighbors2Recv[t] : MPI_PROC_NULL;
+
+        for( v = 0; v < varsNum; v++ ){
+            varDim = varSizeG2[varNames[v]];
+            types[v] = haloSendType[scheme][haloType][t][varDim];
+        }
+        if( payload != nullptr ){
+            blocks[varsNum] = payload->sendCount[t];
+            types[varsNum]  = MPI_DOUBLE;
+            MPI_Get_address(payload->sendBuf[t], &disps[varsNum]);
+        }
+        MPI_Type_create_struct(typesNum, &blocks[0], &disps[0], &types[0], &sendType);
+        MPI_Type_commit(&sendType);
+
+        if( haloType != HALO_G2_GATHER ){
+            for( v = 0; v < varsNum; v++ ){
+                varDim = varSizeG2[varNames[v]];
+                types[v] = haloRecvType[scheme][haloType][t][varDim];
+            }
+            if( payload != nullptr ){
+                blocks[varsNum] = payload->recvCapacity[t];
+                MPI_Get_address(payload->recvBuf[t], &disps[varsNum]);
+            }
+            MPI_Type_create_struct(typesNum, &blocks[0], &disps[0], &types[0], &recvType);
+            MPI_Type_commit(&recvType);
+
+            MPI_Sendrecv(MPI_BOTTOM, 1, sendType, sendTo, t,
+                         MPI_BOTTOM, 1, recvType, recvFrom, t,
+                         MPI_COMM_WORLD, &st);
+            
+            //# the payload is what follows the halo slabs
+            if( payload != nullptr ){
+                payload->recvCount[t] = 0;
+                if( recvFrom != MPI_PROC_NULL ){
+                    int received;
+                    MPI_Get_elements(&st, recvType, &received);
+                    payload->recvCount[t] = received - totDim*
+                                            (rng[0][3] - rng[0][2] + 1)*
+                                            (rng[1][3] - rng[1][2] + 1)*
+                                            (rng[2][3] - rng[2][2] + 1);
                 }
-                
-                counter4Gath[t] = (idxX[1] - idxX[0] + 1)*
-                                  (idxY[1] - idxY[0] + 1)*
-                                  (idxZ[1] - idxZ[0] + 1);
-                
-                sendIdx4Gath[t] = new int[counter4Gath[t]];
-                recvIdx4Gath[t] = new int[counter4Gath[t]];
-                
-                int lineIDX = 0;
-                for( i = idxX[0]; i <= idxX[1]; i++ ){
-                    for( j = idxY[0]; j <= idxY[1]; j++ ){
-                        for( k = idxZ[0]; k <= idxZ[1]; k++ ){
-                            idx = IDX(i, j, k, xResG2, yResG2, zResG2);
-                            sendIdx4Gath[t][lineIDX] = idx;
-                            lineIDX++;
+            }
+
+            MPI_Type_free(&recvType);
+            
+            if( nodeNeighborStore[t] != nullptr ){
+                readNodeNeighbor(varNames, haloType, scheme, t, nullptr);
+            }
+        }else{
+            //# received slab is added, not copied: it goes to a buffer
+            //# and is summed up after all slabs are sent,
+            //# the buffer holds the slab of each component in turn
+            cnt[t] = (rng[0][3] - rng[0][2] + 1)*
+                     (rng[1][3] - rng[1][2] + 1)*
+                     (rng[2][3] - rng[2][2] + 1);
+            recvBuf[t] = scope.borrow<double>(cnt[t]*totDim);
+
+            MPI_Sendrecv(MPI_BOTTOM, 1, sendType, sendTo, t,
+                         recvBuf[t], cnt[t]*totDim, MPI_DOUBLE, recvFrom, t,
+                         MPI_COMM_WORLD, &st);
+            
+            if( nodeNeighborStore[t] != nullptr ){
+                readNodeNeighbor(varNames, haloType, scheme, t, recvBuf[t]);
+            }
+        }
+        MPI_Type_free(&sendType);
+    }
+    
+    //# on-node neighbours have finished reading own slabs
+    if( nodeWin != MPI_WIN_NULL ){
+        MPI_Win_fence(0, nodeWin);
+    }
+
+    if( haloType != HALO_G2_GATHER ){
+        return;
+    }
+
+    int xResG2 = loader->resolution[0]+2,
+        yResG2 = loader->resolution[1]+2,
+        zResG2 = loader->resolution[2]+2;
+
+    for( n = 0; n < neighborsNum; n++ ){
+        t = neighbors[n];
+        int (*rng)[4] = haloRange[scheme][haloType][t];
+
+        if( loader->neighbors2Recv[t] != MPI_PROC_NULL ){
+            shift = 0;
+            for( v = 0; v < varsNum; v++ ){
+                FieldG2 var = getFieldOnG2(varNames[v]);
+                varDim = var.getSize();
+                for( dim = 0; dim < varDim; dim++ ){
+                    double* comp = var.getComponent(dim);
+                    const double* slab = recvBuf[t]+cnt[t]*(shift+dim);
+                    pos = 0;
+                    for( i = rng[0][2]; i <= rng[0][3]; i++ ){
+                        for( j = rng[1][2]; j <= rng[1][3]; j++ ){
+                            for( k = rng[2][2]; k <= rng[2][3]; k++ ){
+                                idx = IDX(i, j, k, xResG2, yResG2, zResG2);
+                                comp[idx] += slab[pos];
+                                pos++;
+                            }
                         }
                     }
                 }
-                
-                lineIDX = 0;
-                for( i = idxX[2]; i <= idxX[3]; i++ ){
-                    for( j = idxY[2]; j <= idxY[3]; j++ ){
-                        for( k = idxZ[2]; k <= idxZ[3]; k++ ){
-                            idx = IDX(i, j, k, xResG2, yResG2, zResG2);
-                            recvIdx4Gath[t][lineIDX] = idx;
-                            lineIDX++;
+                shift += varDim;
+            }
+        }
+    }
+}
+
+
+//  slab of on-node neighbour t is read from its shared storage:
+//  copied into own ghosts (recvBuf = nullptr) or into the buffer
+//  in the layout of a received message (gather)
+void GridManager::readNodeNeighbor(const vector<int>& varNames, int haloType,
+                                   int scheme, int t, double* recvBuf){
+    
+    int (*rng)[4] = haloRange[scheme][haloType][t];
+    int* nbRes = nodeNeighborRes[t];
+    int nbSize[3], srcFrom[3];
+    int offset[3] = {t/9 - 1, (t/3)%3 - 1, t%3 - 1};
+    int e, v, i, j, k, idx, nbIdx, dim, varDim, pos, shift = 0;
+    
+    int xResG2 = loader->resolution[0]+2,
+        yResG2 = loader->resolution[1]+2,
+        zResG2 = loader->resolution[2]+2;
+    
+    //# only the slab along the direction of the message depends on
+    //# the sender's size, tangential sizes are the same
+    for( e = 0; e < 3; e++ ){
+        nbSize[e]  = nbRes[e]+2;
+        srcFrom[e] = offset[e] == 1 ? nbRes[e] : rng[e][0];
+    }
+    long nbStride = alignedStride(nbSize[0]*nbSize[1]*nbSize[2]);
+    int cnt = (rng[0][3] - rng[0][2] + 1)*
+              (rng[1][3] - rng[1][2] + 1)*
+              (rng[2][3] - rng[2][2] + 1);
+    
+    //# variables start at the same component on every rank
+    for( v = 0; v < varNames.size(); v++ ){
+        FieldG2 var = getFieldOnG2(varNames[v]);
+        varDim = var.getSize();
+        for( dim = 0; dim < varDim; dim++ ){
+            double* comp = var.getComponent(dim);
+            const double* nbComp = nodeNeighborStore[t]
+                                 + nbStride*(firstCompG2[varNames[v]]+dim);
+            pos = 0;
+            for( i = rng[0][2]; i <= rng[0][3]; i++ ){
+                for( j = rng[1][2]; j <= rng[1][3]; j++ ){
+                    for( k = rng[2][2]; k <= rng[2][3]; k++ ){
+                        idx   = IDX(i, j, k, xResG2, yResG2, zResG2);
+                        nbIdx = IDX(srcFrom[0]+i-rng[0][2],
+                                    srcFrom[1]+j-rng[1][2],
+                                    srcFrom[2]+k-rng[2][2],
+                                    nbSize[0], nbSize[1], nbSize[2]);
+                        if( recvBuf == nullptr ){
+                            comp[idx] = nbComp[nbIdx];
+                        }else{
+                            recvBuf[cnt*(shift+dim)+pos] = nbComp[nbIdx];
                         }
+                        pos++;
                     }
                 }
             }
         }
+        shift += varDim;
+    }
+}
+
+
+//  directions without a rank on either side are skipped
+vector<int> GridManager::getNeighbors4Stage(int stage){
+    vector<int> neighbors;
+    
+    switch (stage) {
+        case 0: neighbors = {NEIGHBOR_LEFT  , NEIGHBOR_RIGHT}; break;
+        case 1: neighbors = {NEIGHBOR_BOTTOM, NEIGHBOR_TOP  }; break;
+        case 2: neighbors = {NEIGHBOR_BACK  , NEIGHBOR_FRONT}; break;
+        default:
+            return loader->haloNeighbors;
+    }
+    
+    vector<int> withRank;
+    for( int n = 0; n < neighbors.size(); n++ ){
+        if( find(loader->haloNeighbors.begin(), loader->haloNeighbors.end(),
+                 neighbors[n]) != loader->haloNeighbors.end() ){
+            withRank.push_back(neighbors[n]);
+        }
     }
+    return withRank;
 }
 
 
 
 void GridManager::gatherBoundaryUsingNeighbor(int varName){
+    vector<int> varNames = {varName};
+    gatherBoundaryUsingNeighbor(varNames);
+}
+
+
+// all listed variables are packed into one message per neighbour
+void GridManager::gatherBoundaryUsingNeighbor(vector<int> varNames){
     
     auto start_time = high_resolution_clock::now();
-    int varShift = G2nodesNumber*varName;
-    int varDim = nodesG2vars[varShift]->getSize();
+    int varsNum = varNames.size();
     
-    int t;
+    int v, dim;
     int i, j, k;
     int ijk, ijk0, ijk1;
-    double *sendBuf[27];
-    double *recvBuf[27];
-    MPI_Status st;
     
     int xRes = loader->resolution[0],
         yRes = loader->resolution[1],
         zRes = loader->resolution[2];
     
-    const double* varVec;
+    string varsStr = "";
     
-    int idx;
-    for( t = 0; t < 27; t++ ){
-        sendBuf[t] = new double[counter4Gath[t]*varDim*sizeof(double)];
-        recvBuf[t] = new double[counter4Gath[t]*varDim*sizeof(double)];
-        for( i = 0; i < counter4Gath[t]; i++ ){
-            idx = sendIdx4Gath[t][i];
-            varVec = nodesG2vars[varShift+idx]->getValue();
-            for( int dim = 0; dim < varDim; dim++ ){
-                sendBuf[t][varDim*i+dim] = varVec[dim];
-            }
+    for( v = 0; v < varsNum; v++ ){
+        varsStr += to_string(varNames[v])+" ";
+    }
+    
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        for( int stage = 0; stage < 3; stage++ ){
+            sendRecvOnG2(varNames, HALO_G2_GATHER, stage, nullptr);
         }
+    }else{
+        sendRecvOnG2(varNames, HALO_G2_GATHER, ALL_NEIGHBORS, nullptr);
     }
     
     auto end_time1 = high_resolution_clock::now();
-    string msg1 ="[GridManager] gatherBoundaryUsingNeighbor: pack for "+to_string(varName)
+    string msg1 ="[GridManager] gatherBoundaryUsingNeighbor: exchange for "+varsStr
                 +" duration = "+to_string(duration_cast<milliseconds>(end_time1 - start_time).count())
                 +" ms";
     logger->writeMsg(msg1.c_str(), DEBUG);
     
-    
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 ){
-            MPI_Sendrecv(sendBuf[t], counter4Gath[t]*varDim,  MPI_DOUBLE, loader->neighbors2Send[t], t,
-                         recvBuf[t], counter4Gath[t]*varDim,  MPI_DOUBLE, loader->neighbors2Recv[t], t,
-                         MPI_COMM_WORLD, &st);
-        }
-    }
-    
-    auto end_time2 = high_resolution_clock::now();
-    string msg2 ="[GridManager] gatherBoundaryUsingNeighbor: send data for "+to_string(varName)
-                +" duration = "+to_string(duration_cast<milliseconds>(end_time2 - end_time1).count())
-                +" ms";
-    logger->writeMsg(msg2.c_str(), DEBUG);
-    
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 && loader->neighbors2Recv[t] != MPI_PROC_NULL ){
-            for( i = 0; i < counter4Gath[t]; i++ ){
-                idx = recvIdx4Gath[t][i];
-                for( int dim = 0; dim < varDim; dim++ ){
-                    nodesG2vars[varShift+idx]->addValue( dim, recvBuf[t][varDim*i+dim]);
-                }
-            }
-        }
-    }
-    
-    auto end_time3 = high_resolution_clock::now();
-    string msg4 ="[GridManager] gatherBoundaryUsingNeighbor: unpack for "+to_string(varName)
-                +" duration = "+to_string(duration_cast<milliseconds>(end_time3 - end_time2).count())
-                +" ms";
-    logger->writeMsg(msg4.c_str(), DEBUG);
-    
-    
-    for( t = 0; t < 27; t++ ){
-        delete [] sendBuf[t];
-        delete [] recvBuf[t];
-    }
-    
     int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
     
-    if( xRes == 1 ){
-        for( j = 0; j < yResG2; j++ ){
-            for( k = 0; k < zResG2; k++ ){
-                ijk0 = IDX(0, j, k, xResG2, yResG2, zResG2);
-                ijk  = IDX(1, j, k, xResG2, yResG2, zResG2);
-                ijk1 = IDX(2, j, k, xResG2, yResG2, zResG2);
-                
-                nodesG2vars[varShift+ijk0]
-                ->setValue(nodesG2vars[varShift+ijk]->getValue());
-                
-                nodesG2vars[varShift+ijk1]
-                ->setValue(nodesG2vars[varShift+ijk]->getValue());
+    for( v = 0; v < varsNum; v++ ){
+        FieldG2 var = getFieldOnG2(varNames[v]);
+        
+        for( dim = 0; dim < var.getSize(); dim++ ){
+            double* comp = var.getComponent(dim);
+            
+            if( xRes == 1 ){
+                for( j = 0; j < yResG2; j++ ){
+                    for( k = 0; k < zResG2; k++ ){
+                        ijk0 = IDX(0, j, k, xResG2, yResG2, zResG2);
+                        ijk  = IDX(1, j, k, xResG2, yResG2, zResG2);
+                        ijk1 = IDX(2, j, k, xResG2, yResG2, zResG2);
+                        
+                        comp[ijk0] = comp[ijk];
+                        comp[ijk1] = comp[ijk];
+                    }
+                }
             }
-        }
-    }
-    
-    if( yRes == 1 ){
-        for( i = 0; i < xResG2; i++ ){
-            for( k = 0; k < zResG2; k++ ){
-                ijk0 = IDX(i, 0, k, xResG2, yResG2, zResG2);
-                ijk  = IDX(i, 1, k, xResG2, yResG2, zResG2);
-                ijk1 = IDX(i, 2, k, xResG2, yResG2, zResG2);
-                
-                nodesG2vars[varShift+ijk0]
-                ->setValue(nodesG2vars[varShift+ijk]->getValue());
-                
-                nodesG2vars[varShift+ijk1]
-                ->setValue(nodesG2vars[varShift+ijk]->getValue());
+            
+            if( yRes == 1 ){
+                for( i = 0; i < xResG2; i++ ){
+                    for( k = 0; k < zResG2; k++ ){
+                        ijk0 = IDX(i, 0, k, xResG2, yResG2, zResG2);
+                        ijk  = IDX(i, 1, k, xResG2, yResG2, zResG2);
+                        ijk1 = IDX(i, 2, k, xResG2, yResG2, zResG2);
+                        
+                        comp[ijk0] = comp[ijk];
+                        comp[ijk1] = comp[ijk];
+                    }
+                }
             }
-        }
-    }
-    
-    
-    if( zRes == 1 ){
-        for( i = 0; i < xResG2; i++ ){
-            for( j = 0; j < yResG2; j++ ){
-                ijk0 = IDX(i, j, 0, xResG2, yResG2, zResG2);
-                ijk  = IDX(i, j, 1, xResG2, yResG2, zResG2);
-                ijk1 = IDX(i, j, 2, xResG2, yResG2, zResG2);
-                
-                nodesG2vars[varShift+ijk0]
-                ->setValue(nodesG2vars[varShift+ijk]->getValue());
-                
-                nodesG2vars[varShift+ijk1]
-                ->setValue(nodesG2vars[varShift+ijk]->getValue());
+            
+            if( zRes == 1 ){
+                for( i = 0; i < xResG2; i++ ){
+                    for( j = 0; j < yResG2; j++ ){
+                        ijk0 = IDX(i, j, 0, xResG2, yResG2, zResG2);
+                        ijk  = IDX(i, j, 1, xResG2, yResG2, zResG2);
+                        ijk1 = IDX(i, j, 2, xResG2, yResG2, zResG2);
+                        
+                        comp[ijk0] = comp[ijk];
+                        comp[ijk1] = comp[ijk];
+                    }
+                }
             }
         }
     }
     
     auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] gatherBoundaryUsingNeighbor: total for "+to_string(varName)
+    string msg ="[GridManager] gatherBoundaryUsingNeighbor: total for "+varsStr
                 +" duration = "+to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
     logger->writeMsg(msg.c_str(), DEBUG);
 }
 
 
 
-void GridManager::sendRecvIndecis4MPIonG4(){
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int xResG4 = xRes+4, yResG4 = yRes+4, zResG4 = zRes+4;
-    int idx, i, j, k, a, b, c, t;
-    vector<int> idxX, idxY, idxZ;
+// compares the three-stage exchange with the 26-neighbour one
+// on integer-valued data, so that the gather sums are exact
+void GridManager::checkFaceExchange(){
     
-    for( a = -1; a <= 1; a++ ){
-        for( b = -1; b <= 1; b++ ){
-            for( c = -1; c <= 1; c++ ){
-                
-                switch (a) {
-                    case -1: idxX = {3   , 3       , xRes + 3, xRes + 3}; break;
-                    case  0: idxX = {1   , xRes + 2, 1       , xRes + 2}; break;
-                    case  1: idxX = {xRes, xRes    , 0       , 0       }; break;
-                }
-                switch (b) {
-                    case -1: idxY = {3   , 3       , yRes + 3, yRes + 3}; break;
-                    case  0: idxY = {1   , yRes + 2, 1       , yRes + 2}; break;
-                    case  1: idxY = {yRes, yRes    , 0       , 0       }; break;
-                }
-                switch (c) {
-                    case -1: idxZ = {3   , 3       , zRes + 3, zRes + 3}; break;
-                    case  0: idxZ = {1   , zRes + 2, 1       , zRes + 2}; break;
-                    case  1: idxZ = {zRes, zRes    , 0       , 0       }; break;
-                }
-                
-                t = (1 + c) + 3 * ((1 + b) + 3 * (1 + a));
-                
-                counterOnG4[t] = (idxX[1] - idxX[0] + 1)*
-                                 (idxY[1] - idxY[0] + 1)*
-                                 (idxZ[1] - idxZ[0] + 1);
-                sendIdxOnG4[t] = new int[counterOnG4[t]];
-                recvIdxOnG4[t] = new int[counterOnG4[t]];
-                
-                int lineIDX = 0;
-                for (i = idxX[0]; i <= idxX[1]; i++) {
-                    for (j = idxY[0]; j <= idxY[1]; j++) {
-                        for (k = idxZ[0]; k <= idxZ[1]; k++) {
-                            idx = IDX(i,j,k, xResG4, yResG4, zResG4);
-                            sendIdxOnG4[t][lineIDX] = idx;
-                            lineIDX++;
-                        }
-                    }
+    const int varName = PRESSURE_SMO;
+    FieldG2 var = getFieldOnG2(varName);
+    int varDim = var.getSize();
+    int rank, idx, dim, stage, haloType, mismatch = 0, totMismatch;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    vector<int> varNames = {varName};
+    vector<double> result;
+    
+    for( haloType = 0; haloType < 3; haloType++ ){
+        
+        for( int scheme = 0; scheme < 2; scheme++ ){
+            
+            for( idx = 0; idx < G2nodesNumber; idx++ ){
+                for( dim = 0; dim < varDim; dim++ ){
+                    var(idx, dim) = (rank+1)*1000000.0 + varDim*idx + dim;
                 }
-                lineIDX = 0;
-                for (i = idxX[2]; i <= idxX[3]; i++) {
-                    for (j = idxY[2]; j <= idxY[3]; j++) {
-                        for (k = idxZ[2]; k <= idxZ[3]; k++) {
-                            idx = IDX(i,j,k, xResG4, yResG4, zResG4);
-                            recvIdxOnG4[t][lineIDX] = idx;
-                            lineIDX++;
-                        }
+            }
+            
+            for( stage = scheme == 0 ? ALL_NEIGHBORS : 0;
+                 stage < (scheme == 0 ? 0 : 3); stage++ ){
+                sendRecvOnG2(varNames, haloType, stage, nullptr);
+            }
+            
+            for( idx = 0; idx < G2nodesNumber; idx++ ){
+                for( dim = 0; dim < varDim; dim++ ){
+                    if( scheme == 0 ){
+                        result.push_back(var(idx, dim));
+                    }else if( result[varDim*idx+dim] != var(idx, dim) ){
+                        mismatch++;
                     }
                 }
             }
         }
+        result.clear();
+    }
+    
+    for( idx = 0; idx < G2nodesNumber; idx++ ){
+        for( dim = 0; dim < varDim; dim++ ){
+            var(idx, dim) = 0.0;
+        }
+    }
+    
+    MPI_Allreduce(&mismatch, &totMismatch, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    
+    if( totMismatch != 0 ){
+        string msg ="[GridManager] three-stage face exchange differs from 26-neighbour exchange in "
+                    +to_string(totMismatch)+" values";
+        logger->writeMsg(msg.c_str(), CRITICAL);
+        throw runtime_error("halo exchange validation failed!");
     }
+    logger->writeMsg("[GridManager] three-stage face exchange validated against 26-neighbour exchange", INFO);
 }
 
 
 
-void GridManager::fillG4Boundary4outflowBC(double* varValues, int varDim){
+//  one (1/4, 1/2, 1/4) pass along an axis of a G2 component, in place.
+//  Nodes are visited as runs of len contiguous nodes (planes for x,
+//  lines for y, single nodes for z), num positions along the axis with
+//  stride between neighbours; buf holds the original values of two runs.
+//  End (ghost) positions are smoothed only on a side without neighbour,
+//  with the outer value extrapolated linearly, otherwise they are left
+//  for the halo exchange.
+static void smoothRuns(double* base, int num, long len, long stride,
+                       const int extrapolate[2], double* buf){
     
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG4 = xRes+4, yResG4 = yRes+4, zResG4 = zRes+4;
-    int idx2use1, idx2use2, idx2set;
-    double * vectorVar1;
-    double * vectorVar2;
-    double val;
-    int i, j, k, dim;
-    
-    if (loader->neighbors2Send[NEIGHBOR_LEFT] == MPI_PROC_NULL){
-        for ( j=0; j<yResG4; j++){
-            for ( k=0; k<zResG4; k++){
-                idx2use1 = IDX(1,j,k, xResG4,yResG4,zResG4);
-                idx2use2 = IDX(2,j,k, xResG4,yResG4,zResG4);
-                idx2set  = IDX(0,j,k, xResG4,yResG4,zResG4);
-                vectorVar1 = &varValues[varDim*idx2use1];
-                vectorVar2 = &varValues[varDim*idx2use2];
-                
-                for ( dim = 0; dim < varDim; dim++) {
-                    val = 2.0*vectorVar1[dim] - vectorVar2[dim];
-                    varValues[varDim*idx2set+dim] = val;
-                }
-            }
-        }
-    }
+    double* prev = buf;
+    double* cur  = buf+len;
+    double* run;
+    long n;
+    int p;
     
-    if (loader->neighbors2Send[NEIGHBOR_RIGHT] == MPI_PROC_NULL){
-        for ( j=0; j<yResG4; j++){
-            for ( k=0; k<zResG4; k++){
-                
-                idx2use1 = IDX(xResG4-2,j,k, xResG4,yResG4,zResG4);
-                idx2use2 = IDX(xResG4-3,j,k, xResG4,yResG4,zResG4);
-                idx2set  = IDX(xResG4-1,j,k, xResG4,yResG4,zResG4);
-                vectorVar1 = &varValues[varDim*idx2use1];
-                vectorVar2 = &varValues[varDim*idx2use2];
-                
-                for ( dim = 0; dim < varDim; dim++) {
-                    val = 2.0*vectorVar1[dim] - vectorVar2[dim];
-                    varValues[varDim*idx2set+dim] = val;
-                }
-                
-            }
+    copy(base, base+len, prev);
+    
+    if( extrapolate[0] ){
+        double* next = base+stride;
+        for( n = 0; n < len; n++ ){
+            base[n] = 0.25*(2.0*prev[n]-next[n]) + 0.5*prev[n] + 0.25*next[n];
         }
     }
     
-    if (loader->neighbors2Send[NEIGHBOR_BOTTOM] == MPI_PROC_NULL){
-        for ( i=0; i<xResG4; i++){
-            for ( k=0; k<zResG4; k++){
-                
-                idx2use1 = IDX(i,1,k, xResG4,yResG4,zResG4);
-                idx2use2 = IDX(i,2,k, xResG4,yResG4,zResG4);
-                idx2set  = IDX(i,0,k, xResG4,yResG4,zResG4);
-                vectorVar1 = &varValues[varDim*idx2use1];
-                vectorVar2 = &varValues[varDim*idx2use2];
-                
-                for ( dim = 0; dim < varDim; dim++) {
-                    val = 2.0*vectorVar1[dim] - vectorVar2[dim];
-                    varValues[varDim*idx2set+dim] = val;
-                }
-                
-                
-            }
+    for( p = 1; p < num-1; p++ ){
+        run = base+p*stride;
+        copy(run, run+len, cur);
+        for( n = 0; n < len; n++ ){
+            run[n] = 0.25*prev[n] + 0.5*cur[n] + 0.25*run[n+stride];
         }
+        swap(prev, cur);
     }
     
-    if (loader->neighbors2Send[NEIGHBOR_TOP] == MPI_PROC_NULL){
-        for ( i=0; i<xResG4; i++){
-            for ( k=0; k<zResG4; k++){
-                
-                idx2use1 = IDX(i,yResG4-2,k, xResG4,yResG4,zResG4);
-                idx2use2 = IDX(i,yResG4-3,k, xResG4,yResG4,zResG4);
-                idx2set  = IDX(i,yResG4-1,k, xResG4,yResG4,zResG4);
-                vectorVar1 = &varValues[varDim*idx2use1];
-                vectorVar2 = &varValues[varDim*idx2use2];
-                
-                for ( dim = 0; dim < varDim; dim++) {
-                    val = 2.0*vectorVar1[dim] - vectorVar2[dim];
-                    varValues[varDim*idx2set+dim] = val;
-                }
-                
-            }
+    if( extrapolate[1] ){
+        run = base+(num-1)*stride;
+        for( n = 0; n < len; n++ ){
+            run[n] = 0.25*prev[n] + 0.5*run[n] + 0.25*(2.0*run[n]-prev[n]);
         }
     }
+}
+
+
+//  z is the contiguous axis: each line is copied into the buffer
+static void smoothLines(double* base, long linesNum, int num,
+                        const int extrapolate[2], double* buf){
     
-    if (loader->neighbors2Send[NEIGHBOR_BACK] == MPI_PROC_NULL){
-        for ( i=0; i<xResG4; i++){
-            for ( j=0; j<yResG4; j++){
-                
-                idx2use1 = IDX(i,j,1,xResG4,yResG4,zResG4);
-                idx2use2 = IDX(i,j,2,xResG4,yResG4,zResG4);
-                idx2set  = IDX(i,j,0,xResG4,yResG4,zResG4);
-                vectorVar1 = &varValues[varDim*idx2use1];
-                vectorVar2 = &varValues[varDim*idx2use2];
-                
-                for ( dim = 0; dim < varDim; dim++) {
-                    val = 2.0*vectorVar1[dim] - vectorVar2[dim];
-                    varValues[varDim*idx2set+dim] = val;
-                }
-            }
+    double* line;
+    int k;
+    
+    for( long l = 0; l < linesNum; l++ ){
+        line = base+l*num;
+        copy(line, line+num, buf);
+        
+        for( k = 1; k < num-1; k++ ){
+            line[k] = 0.25*buf[k-1] + 0.5*buf[k] + 0.25*buf[k+1];
+        }
+        if( extrapolate[0] ){
+            line[0] = 0.25*(2.0*buf[0]-buf[1]) + 0.5*buf[0] + 0.25*buf[1];
+        }
+        if( extrapolate[1] ){
+            line[num-1] = 0.25*buf[num-2] + 0.5*buf[num-1]
+                        + 0.25*(2.0*buf[num-1]-buf[num-2]);
         }
     }
+}
+
+
+//  27-point binomial filter (weights 1/8, 1/16, 1/32, 1/64) as the product
+//  of three (1/4, 1/2, 1/4) passes along x, y and z over a block of
+//  n[0] x n[1] x n[2] nodes, end nodes are smoothed only if extrapolated.
+//  Threads take the same part of every plane along x, whole planes along y
+//  and lines along z; buf holds 2*max(plane, threads*n[2]) doubles
+static void smoothBlock(double* comp, const int n[3], const int extrapolate[3][2],
+                        double* buf){
     
-    if (loader->neighbors2Send[NEIGHBOR_FRONT] == MPI_PROC_NULL){
-        for ( i=0; i<xResG4; i++){
-            for ( j=0; j<yResG4; j++){
-                
-                idx2use1 = IDX(i,j,zResG4-2, xResG4,yResG4,zResG4);
-                idx2use2 = IDX(i,j,zResG4-3, xResG4,yResG4,zResG4);
-                idx2set  = IDX(i,j,zResG4-1, xResG4,yResG4,zResG4);
-                vectorVar1 = &varValues[varDim*idx2use1];
-                vectorVar2 = &varValues[varDim*idx2use2];
-                
-                for ( dim = 0; dim < varDim; dim++) {
-                    val = 2.0*vectorVar1[dim] - vectorVar2[dim];
-                   varValues[varDim*idx2set+dim] = val;
-                }
-                
-            }
+    long plane = long(n[1])*n[2];
+    long linesNum = long(n[0])*n[1];
+    
+    OMP(parallel)
+    {
+        long from, to;
+        getThreadShare(plane, from, to);
+        smoothRuns(comp+from, n[0], to-from, plane, extrapolate[0], buf+2*from);
+        
+        double* threadBuf = buf+2*long(n[2])*getThreadNum();
+        OMP(barrier)
+        
+        OMP(for schedule(static))
+        for( int i = 0; i < n[0]; i++ ){
+            smoothRuns(comp+i*plane, n[1], n[2], n[2], extrapolate[1], threadBuf);
         }
+        
+        getThreadShare(linesNum, from, to);
+        smoothLines(comp+from*n[2], to-from, n[2], extrapolate[2], threadBuf);
     }
-    
- }
+}
 
 
-void GridManager::smooth(int varName){
+//  filter on all components of the listed variables.
+//  Interior nodes and ghosts on the sides without neighbour are smoothed,
+//  ghosts shared with neighbours are refreshed by the following exchange
+void GridManager::smoothInPlace(const vector<int>& varNames){
     
-    int i, j, k, idx, idxG4;
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG4 = xRes+4, yResG4 = yRes+4, zResG4 = zRes+4;
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int totG4 = xResG4*yResG4*zResG4;
-    auto start_time = high_resolution_clock::now();
-    int varShift = G2nodesNumber*varName;
-    int varDim = nodesG2vars[varShift]->getSize();
-    int t;
-    double *sendBuf[27];
-    double *recvBuf[27];
-    const double* vectorVar;
+    int n[3] = {loader->resolution[0]+2,
+                loader->resolution[1]+2,
+                loader->resolution[2]+2};
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+    int extrapolate[3][2];
+    
+    for( int e = 0; e < 3; e++ ){
+        extrapolate[e][0] = loader->neighbors2Send[faces[2*e]]   == MPI_PROC_NULL;
+        extrapolate[e][1] = loader->neighbors2Send[faces[2*e+1]] == MPI_PROC_NULL;
+    }
     
-    double* varValues = new double[totG4*varDim*sizeof(double)];
+    long plane = long(n[1])*n[2];
+    WorkspaceScope scope(*workspace);
+    double* buf = scope.borrow<double>(2*max(plane, long(getThreadsNum())*n[2]));
     
-    for( idxG4 = 0; idxG4 < totG4; idxG4++ ){
-        for (int dim = 0; dim < varDim; dim++) {
-            varValues[varDim*idxG4+dim] = 0.0;
+    for( int v = 0; v < varNames.size(); v++ ){
+        FieldG2 var = getFieldOnG2(varNames[v]);
+        
+        for( int dim = 0; dim < var.getSize(); dim++ ){
+            smoothBlock(var.getComponent(dim), n, extrapolate, buf);
         }
     }
+}
+
+
+//  neighbours along every axis must hold the ghost layers of the
+//  workspace in their interior, otherwise one exchange per pass is used.
+//  The workspace is private to the rank, so with shared memory the
+//  halos of smoothing stay in the shared G2 storage as well
+void GridManager::initSmoothGhostWidth(){
     
-    for( i= 0 ; i < xResG2; i++ ){
-        for( j = 0; j < yResG2; j++ ){
-            for( k = 0; k < zResG2; k++ ){
-                idx   = IDX(i  ,j  ,k  ,xResG2,yResG2,zResG2);
-                idxG4 = IDX(i+1,j+1,k+1,xResG4,yResG4,zResG4);
-                vectorVar = nodesG2vars[varShift+idx]->getValue();
-                for( int dim = 0; dim < varDim; dim++ ){
-                    varValues[varDim*idxG4+dim] = vectorVar[dim];
-                }
-            }
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+    int width = loader->ghostWidth, minWidth;
+    string reason = "exceed the resolution of some domain";
+    
+    for( int side = 0; side < 6; side++ ){
+        if( loader->neighbors2Send[faces[side]] != MPI_PROC_NULL
+           && loader->resolution[side/2] < width ){
+            width = 1;
         }
     }
+    if( loader->useSharedMemory ){
+        width = 1;
+        reason = "are not exchanged through shared memory";
+    }
+    MPI_Allreduce(&width, &minWidth, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    smoothGhostWidth = minWidth;
+    
+    if( smoothGhostWidth != loader->ghostWidth ){
+        string msg ="[GridManager] "+to_string(loader->ghostWidth)
+                    +" ghost layers of smoothing "+reason+","
+                    +" smoothing uses one exchange per pass";
+        logger->writeMsg(msg.c_str(), INFO);
+    }
+    
+    if( smoothGhostWidth > 1 ){
+        initGhostDatatypes();
+    }
+}
+
+
+//  ghost slabs of the workspace as HALO_G2_SMOOTHED with smoothGhostWidth
+//  layers: next to the shared face the layers, along the other axes the
+//  interior and the ghosts of the sides without neighbour. A face slab of
+//  the three-stage exchange also takes the ghost layers received in the
+//  stages before, as the slabs of initHaloRanges do
+void GridManager::initGhostDatatypes(){
     
-    fillG4Boundary4outflowBC(varValues, varDim);
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+    int W = smoothGhostWidth;
+    int lo[3], n[3], subsizes[3], starts[3], offset[3];
+    int rng[2][3][2];
+    int scheme, e, d, t, side;
     
+    getGhostedBlockSize(lo, n);
     
-    for( t = 0; t < 27; t++ ){
-        sendBuf[t] = new double[counterOnG4[t]*varDim*sizeof(double)];
-        recvBuf[t] = new double[counterOnG4[t]*varDim*sizeof(double)];
-        for( i = 0; i < counterOnG4[t]; i++ ){
-            int si = sendIdxOnG4[t][i];
-            for( int dim = 0; dim < varDim; dim++ ){
-                sendBuf[t][varDim*i+dim] = varValues[varDim*si+dim];
+    int schemesNum = loader->haloExchangeType == FACE_STAGED_EXCHANGE ? 2 : 1;
+    
+    for( scheme = 0; scheme < schemesNum; scheme++ ){
+        
+        vector<int> neighbors = getNeighbors4Stage(ALL_NEIGHBORS);
+        if( scheme == 1 ){
+            neighbors = vector<int>(faces, faces+6);
+        }
+        
+        for( int nb = 0; nb < neighbors.size(); nb++ ){
+            t = neighbors[nb];
+            offset[0] = t/9 - 1;
+            offset[1] = (t/3)%3 - 1;
+            offset[2] = t%3 - 1;
+            
+            //# axis of the face
+            d = offset[0] != 0 ? 0 : (offset[1] != 0 ? 1 : 2);
+            
+            for( e = 0; e < 3; e++ ){
+                int R = loader->resolution[e];
+                int noLeft  = loader->neighbors2Send[faces[2*e]]   == MPI_PROC_NULL;
+                int noRight = loader->neighbors2Send[faces[2*e+1]] == MPI_PROC_NULL;
+                switch (offset[e]) {
+                    case -1:
+                        rng[0][e][0] = 1;     rng[0][e][1] = W;
+                        rng[1][e][0] = R+1;   rng[1][e][1] = R+W;
+                        break;
+                    case 1:
+                        rng[0][e][0] = R-W+1; rng[0][e][1] = R;
+                        rng[1][e][0] = 1-W;   rng[1][e][1] = 0;
+                        break;
+                    default:
+                        if( scheme == 1 && e < d ){
+                            rng[0][e][0] = noLeft  ? 0   : 1-W;
+                            rng[0][e][1] = noRight ? R+1 : R+W;
+                        }else{
+                            rng[0][e][0] = noLeft  ? 0   : 1;
+                            rng[0][e][1] = noRight ? R+1 : R;
+                        }
+                        rng[1][e][0] = rng[0][e][0];
+                        rng[1][e][1] = rng[0][e][1];
+                }
+            }
+            
+            for( side = 0; side < 2; side++ ){
+                MPI_Datatype* slabType = side == 0 ? &ghostSendType[scheme][t]
+                                                   : &ghostRecvType[scheme][t];
                 
+                //# without the rank the ghost layers may be missing
+                int rank = side == 0 ? loader->neighbors2Send[t] : loader->neighbors2Recv[t];
+                if( rank == MPI_PROC_NULL ){
+                    *slabType = MPI_DATATYPE_NULL;
+                    continue;
+                }
+                for( e = 0; e < 3; e++ ){
+                    starts[e]   = rng[side][e][0]+lo[e]-1;
+                    subsizes[e] = rng[side][e][1]-rng[side][e][0]+1;
+                }
+                MPI_Type_create_subarray(3, n, subsizes, starts, MPI_ORDER_C,
+                                         MPI_DOUBLE, slabType);
+                MPI_Type_commit(slabType);
+                haloTypes.push_back(*slabType);
             }
         }
     }
+}
+
 
+//  passes of the filter with one exchange: the listed variables are copied
+//  into a workspace with smoothGhostWidth ghost layers on the sides with
+//  neighbour (one on the others), the neighbours fill them, and every pass
+//  smooths the ghost layers too. Each pass leaves the outermost layer
+//  wrong, the rest equals the neighbour's own values, so after at most
+//  width-1 passes the interior and the G2 ghosts are those of the
+//  smoothing in place with an exchange after every pass.
+//  BC between passes is applied to the workspace as applyBC does
+void GridManager::smoothWithGhosts(const vector<int>& varNames, int passes){
     
-    MPI_Status st;
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 ){
-            MPI_Sendrecv(sendBuf[t], counterOnG4[t]*varDim, MPI_DOUBLE, loader->neighbors2Send[t], t,
-                         recvBuf[t], counterOnG4[t]*varDim, MPI_DOUBLE, loader->neighbors2Recv[t], t,
-                         MPI_COMM_WORLD, &st);
-        }
+    GhostedBlock block;
+    initGhostedBlock(varNames, block);
+    
+    int nG2[3], e, v, dim, i, j, k;
+    for( e = 0; e < 3; e++ ){
+        nG2[e] = loader->resolution[e]+2;
     }
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 && loader->neighbors2Recv[t] != MPI_PROC_NULL ){
-            for( i = 0; i < counterOnG4[t]; i++ ){
-                int ri = recvIdxOnG4[t][i];
-                for( int dim = 0; dim < varDim; dim++ ){
-                    varValues[varDim*ri+dim] = recvBuf[t][varDim*i+dim];
+    const int* lo = block.lo;
+    const int* n  = block.n;
+    
+    int shift = 0;
+    for( v = 0; v < varNames.size(); v++ ){
+        FieldG2 var = getFieldOnG2(varNames[v]);
+        for( dim = 0; dim < var.getSize(); dim++ ){
+            const double* comp = var.getComponent(dim);
+            double* wcomp = &block.work[block.nodesNum*(shift+dim)];
+            for( i = 0; i < nG2[0]; i++ ){
+                for( j = 0; j < nG2[1]; j++ ){
+                    for( k = 0; k < nG2[2]; k++ ){
+                        wcomp[IDX(i+lo[0]-1, j+lo[1]-1, k+lo[2]-1, n[0], n[1], n[2])]
+                            = comp[IDX(i, j, k, nG2[0], nG2[1], nG2[2])];
+                    }
                 }
             }
         }
+        shift += var.getSize();
+    }
+    
+    filterGhostedBlock(block, passes);
+    workspace->release(block.workspaceMark);
+}
+
+
+//  ghost layers before the first interior node and nodes per axis of
+//  the workspace: smoothGhostWidth on the sides with neighbour, one
+//  on the others
+void GridManager::getGhostedBlockSize(int lo[3], int n[3]){
+    
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+    
+    for( int e = 0; e < 3; e++ ){
+        int noLeft  = loader->neighbors2Send[faces[2*e]]   == MPI_PROC_NULL;
+        int noRight = loader->neighbors2Send[faces[2*e+1]] == MPI_PROC_NULL;
+        lo[e] = noLeft ? 1 : smoothGhostWidth;
+        n[e]  = loader->resolution[e]+lo[e]+(noRight ? 1 : smoothGhostWidth);
     }
+}
+
+
+//  geometry and storage of the workspace, its content is left to the
+//  caller; the storage is borrowed until the block is smoothed
+void GridManager::initGhostedBlock(const vector<int>& varNames, GhostedBlock& block){
     
+    int totDim = 0;
     
-    for( t = 0; t < 27; t++ ){
-        delete [] sendBuf[t];
-        delete [] recvBuf[t];
-    }
-    
-    int zeroOrderNeighb[6][3]  =
-       {{-1,0 ,0 }, {+1,0 ,0 },
-        {0 ,-1,0 }, {0 ,+1,0 },
-        {0 ,0 ,-1}, {0 ,0 ,+1}};
-    
-    int firstOrderNeighb[12][3] =
-       {{-1,-1, 0}, {-1,+1, 0},
-        {-1, 0,-1}, {-1, 0,+1},
-        {0 ,-1,-1}, { 0,-1,+1},
-        {0 ,+1,-1}, { 0,+1,+1},
-        {+1, 0,-1}, {+1, 0,+1},
-        {+1,-1, 0}, {+1,+1, 0}};
-    
-    int secndOrderNeighb[8][3] =
-       {{-1,-1,-1}, {-1,-1,+1},
-        {-1,+1,-1}, {-1,+1,+1},
-        {+1,-1,-1}, {+1,-1,+1},
-        {+1,+1,-1}, {+1,+1,+1}};
-    
-    const double k2 = 0.125;// 1/8
-    const double k3 = 0.0625;// 1/16
-    const double k4 = 0.03125;// 1/32
-    const double k5 = 0.015625;// 1/64
-//                    +--------
-//  0.125*1+0.0625*6+0.03125*12+0.015625*8 = 1
-    
-    int foi, soi, toi;
-    int idxFo, idxSo, idxTo;
-    
-    for( i=1; i<xResG2+1; i++ ){
-        for( j=1; j<yResG2+1; j++ ){
-            for( k=1; k<zResG2+1; k++ ){
-                idxG4 = IDX(i,j,k,xResG4,yResG4,zResG4);
-
-                for( int dim = 0; dim < varDim; dim++){
-                    
-                    double smoothedVal = k2*varValues[varDim*idxG4+dim];
-                    
-                    for(foi = 0; foi<6; foi++){
-                        idxFo = IDX(i+zeroOrderNeighb[foi][0],
-                                    j+zeroOrderNeighb[foi][1],
-                                    k+zeroOrderNeighb[foi][2],
-                                    xResG4,yResG4,zResG4);
-                        smoothedVal += k3*varValues[varDim*idxFo+dim];
-                    }
-                    
-                    for(soi = 0; soi<12; soi++){
-                        idxSo = IDX(i+firstOrderNeighb[soi][0],
-                                    j+firstOrderNeighb[soi][1],
-                                    k+firstOrderNeighb[soi][2],
-                                    xResG4,yResG4,zResG4);
-                        smoothedVal += k4*varValues[varDim*idxSo+dim];
-                    }
-                    
-                    for(toi = 0; toi<8; toi++){
-                        idxTo = IDX(i+secndOrderNeighb[toi][0],
-                                    j+secndOrderNeighb[toi][1],
-                                    k+secndOrderNeighb[toi][2],
-                                    xResG4,yResG4,zResG4);
-                        smoothedVal += k5*varValues[varDim*idxTo+dim];
+    getGhostedBlockSize(block.lo, block.n);
+    for( int v = 0; v < varNames.size(); v++ ){
+        totDim += varSizeG2[varNames[v]];
+    }
+    
+    block.varNames = varNames;
+    block.nodesNum = long(block.n[0])*block.n[1]*block.n[2];
+    block.totDim = totDim;
+    block.workspaceMark = workspace->getMark();
+    block.work = workspace->borrow<double>(block.nodesNum*totDim);
+    fill(block.work, block.work+block.nodesNum*totDim, 0.0);
+}
+
+
+//  workspace for a kernel that writes the interior nodes of the listed
+//  variables into it instead of the grid, false if smoothing does not use
+//  deep ghost layers. The G2 ghosts are copied in: with BC the kernel
+//  does not write them, the smoothing takes them from here
+bool GridManager::openGhostedBlock(const vector<int>& varNames, GhostedBlock& block){
+    
+    if( smoothGhostWidth < 2 ){
+        return false;
+    }
+    
+    initGhostedBlock(varNames, block);
+    
+    int nG2[3], i, j, k, dim;
+    for( int e = 0; e < 3; e++ ){
+        nG2[e] = loader->resolution[e]+2;
+    }
+    const int* lo = block.lo;
+    const int* n  = block.n;
+    
+    int shift = 0;
+    for( int v = 0; v < varNames.size(); v++ ){
+        FieldG2 var = getFieldOnG2(varNames[v]);
+        for( dim = 0; dim < var.getSize(); dim++ ){
+            const double* comp = var.getComponent(dim);
+            double* wcomp = &block.work[block.nodesNum*(shift+dim)];
+            for( i = 0; i < nG2[0]; i++ ){
+                for( j = 0; j < nG2[1]; j++ ){
+                    int inner = i > 0 && i < nG2[0]-1 && j > 0 && j < nG2[1]-1;
+                    int kStep = inner ? nG2[2]-1 : 1;
+                    for( k = 0; k < nG2[2]; k += kStep ){
+                        wcomp[IDX(i+lo[0]-1, j+lo[1]-1, k+lo[2]-1, n[0], n[1], n[2])]
+                            = comp[IDX(i, j, k, nG2[0], nG2[1], nG2[2])];
                     }
-                    idx = IDX(i-1,j-1,k-1,xResG2,yResG2,zResG2);
-                    nodesG2vars[varShift+idx]->setValue(dim, smoothedVal);
                 }
             }
         }
+        shift += var.getSize();
     }
+    return true;
+}
+
+
+//  smoothing of a workspace filled by a kernel: BC, one exchange and the
+//  first width-1 passes, the result goes to the grid; more passes, if
+//  any, as smooth() does. BC after the last pass is left to the caller
+void GridManager::smoothGhostedBlock(GhostedBlock& block){
+    
+    auto start_time = high_resolution_clock::now();
     
+    int passes = min(smoothGhostWidth-1, loader->smoothIterations);
+    filterGhostedBlock(block, passes);
+    workspace->release(block.workspaceMark);
+    smoothPasses(block.varNames, passes);
     
-    delete [] varValues;
     auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] smooth "+to_string(varName)
-                +" duration = "+to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    string msg ="[GridManager] smooth ghosted block duration = "
+                +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
     logger->writeMsg(msg.c_str(), DEBUG);
-    
 }
 
-void GridManager::smoothDensAndIonVel(){
-    
-    int i, j, k, idx, idxG4;
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG4 = xRes+4, yResG4 = yRes+4, zResG4 = zRes+4;
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int totG4 = xResG4*yResG4*zResG4;
-    auto start_time = high_resolution_clock::now();
-    int varDim = 4;
-    int t;
-    double *sendBuf[27];
-    double *recvBuf[27];
-    const double* vectorVar;
+
+//  same value BC on the sides without neighbour (before the exchange the
+//  G2 block already has it unless filled by a kernel, applying it twice
+//  changes nothing), ghost layers from the neighbours, then the passes;
+//  the G2 block of the workspace is copied back to the grid
+void GridManager::filterGhostedBlock(GhostedBlock& block, int passes){
+    
+    int faces[6] = {NEIGHBOR_LEFT, NEIGHBOR_RIGHT,
+                    NEIGHBOR_BOTTOM, NEIGHBOR_TOP,
+                    NEIGHBOR_BACK, NEIGHBOR_FRONT};
+    int nG2[3], extrapolate[3][2];
+    int e, v, dim, i, j, k, side, pass, comp;
+    const int* lo = block.lo;
+    const int* n  = block.n;
+    
+    for( e = 0; e < 3; e++ ){
+        extrapolate[e][0] = loader->neighbors2Send[faces[2*e]]   == MPI_PROC_NULL;
+        extrapolate[e][1] = loader->neighbors2Send[faces[2*e+1]] == MPI_PROC_NULL;
+        nG2[e] = loader->resolution[e]+2;
+    }
     
-    double* densVel = new double[totG4*varDim*sizeof(double)];
+    long nodesNum = block.nodesNum;
+    long plane = long(n[1])*n[2];
+    long stride[3] = {plane, n[2], 1};
+    int totDim = block.totDim;
+    WorkspaceScope scope(*workspace);
+    double* buf = scope.borrow<double>(2*max(plane, long(getThreadsNum())*n[2]));
     
-    for ( idxG4 = 0; idxG4 < totG4; idxG4++ ){
-        for( int dim = 0; dim < varDim; dim++ ){
-            densVel[varDim*idxG4+dim] = 0.0;
+    for( pass = -1; pass < passes; pass++ ){
+        
+        //# exchange after the BC, passes after the exchange
+        if( pass == 0 ){
+            exchangeGhosts(block);
         }
-    }
-    
-    for( i = 0; i < xResG2; i++ ){
-        for( j = 0; j < yResG2; j++ ){
-            for( k = 0; k < zResG2; k++ ){
-                idx   = IDX(i  ,j  ,k  ,xResG2,yResG2,zResG2);
-                idxG4 = IDX(i+1,j+1,k+1,xResG4,yResG4,zResG4);
-                
-                vectorVar = nodesG2vars[G2nodesNumber*DENSELEC+idx]->getValue();
-                densVel[varDim*idxG4+0] = vectorVar[0];
-                vectorVar = nodesG2vars[G2nodesNumber*VELOCION+idx]->getValue();
-                for( int dim = 1; dim < varDim; dim++ ){
-                    densVel[varDim*idxG4+dim] = vectorVar[dim-1];
+        
+        for( comp = 0; comp < totDim; comp++ ){
+            double* wcomp = &block.work[nodesNum*comp];
+            
+            //# same value BC: x faces, then y and z faces
+            if( pass != 0 ){
+                for( e = 0; e < 3; e++ ){
+                    if( loader->BCtype[e] != DAMPING || loader->resolution[e] == 1 ){
+                        continue;
+                    }
+                    for( side = 0; side < 2; side++ ){
+                        if( !extrapolate[e][side] ){
+                            continue;
+                        }
+                        int from[3] = {0, 0, 0};
+                        int to[3]   = {n[0], n[1], n[2]};
+                        from[e] = side == 0 ? 0 : n[e]-1;
+                        to[e]   = from[e]+1;
+                        long src = side == 0 ? stride[e] : -stride[e];
+                        for( i = from[0]; i < to[0]; i++ ){
+                            for( j = from[1]; j < to[1]; j++ ){
+                                for( k = from[2]; k < to[2]; k++ ){
+                                    long idx = IDX(i, j, k, n[0], n[1], n[2]);
+                                    wcomp[idx] = wcomp[idx+src];
+                                }
+                            }
+                        }
+                    }
                 }
             }
+            
+            if( pass >= 0 ){
+                smoothBlock(wcomp, n, extrapolate, buf);
+            }
         }
     }
     
-    fillG4Boundary4outflowBC(densVel, varDim);
-    
-    for( t = 0; t < 27; t++ ){
-        sendBuf[t] = new double[counterOnG4[t]*varDim*sizeof(double)];
-        recvBuf[t] = new double[counterOnG4[t]*varDim*sizeof(double)];
-        for( i = 0; i < counterOnG4[t]; i++ ){
-            int si = sendIdxOnG4[t][i];
-            for( int dim = 0; dim < varDim; dim++ ){
-                sendBuf[t][varDim*i+dim] = densVel[varDim*si+dim];
-                
+    int shift = 0;
+    for( v = 0; v < block.varNames.size(); v++ ){
+        FieldG2 var = getFieldOnG2(block.varNames[v]);
+        for( dim = 0; dim < var.getSize(); dim++ ){
+            double* comp = var.getComponent(dim);
+            const double* wcomp = &block.work[nodesNum*(shift+dim)];
+            for( i = 0; i < nG2[0]; i++ ){
+                for( j = 0; j < nG2[1]; j++ ){
+                    for( k = 0; k < nG2[2]; k++ ){
+                        comp[IDX(i, j, k, nG2[0], nG2[1], nG2[2])]
+                            = wcomp[IDX(i+lo[0]-1, j+lo[1]-1, k+lo[2]-1, n[0], n[1], n[2])];
+                    }
+                }
             }
         }
+        shift += var.getSize();
     }
+}
+
+
+//  ghost layers of the workspace from the neighbours, one message per
+//  neighbour (or per face and stage with the three-stage exchange) for
+//  all its variables, sent straight from the workspace with the slab
+//  datatypes of initGhostDatatypes
+void GridManager::exchangeGhosts(GhostedBlock& block){
     
+    int faceStaged = loader->haloExchangeType == FACE_STAGED_EXCHANGE;
+    int stagesNum = faceStaged ? 3 : 1;
+    int scheme = faceStaged ? 1 : 0;
+    MPI_Aint compStride = sizeof(double)*block.nodesNum;
     MPI_Status st;
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 ){
-            MPI_Sendrecv(sendBuf[t], counterOnG4[t]*varDim, MPI_DOUBLE, loader->neighbors2Send[t], t,
-                         recvBuf[t], counterOnG4[t]*varDim, MPI_DOUBLE, loader->neighbors2Recv[t], t,
+    
+    for( int stage = 0; stage < stagesNum; stage++ ){
+        
+        vector<int> neighbors = getNeighbors4Stage(faceStaged ? stage : ALL_NEIGHBORS);
+        
+        for( int nb = 0; nb < neighbors.size(); nb++ ){
+            int t = neighbors[nb];
+            
+            //# nothing goes to or comes from a missing rank
+            MPI_Datatype slabTypes[2] = {ghostSendType[scheme][t], ghostRecvType[scheme][t]};
+            MPI_Datatype types[2] = {MPI_DOUBLE, MPI_DOUBLE};
+            int counts[2] = {0, 0};
+            for( int side = 0; side < 2; side++ ){
+                if( slabTypes[side] != MPI_DATATYPE_NULL ){
+                    MPI_Type_create_hvector(block.totDim, 1, compStride, slabTypes[side], &types[side]);
+                    MPI_Type_commit(&types[side]);
+                    counts[side] = 1;
+                }
+            }
+            
+            MPI_Sendrecv(block.work, counts[0], types[0], loader->neighbors2Send[t], t,
+                         block.work, counts[1], types[1], loader->neighbors2Recv[t], t,
                          MPI_COMM_WORLD, &st);
-        }
-    }
-    for( t = 0; t < 27; t++ ){
-        if( t != 13 && loader->neighbors2Recv[t] != MPI_PROC_NULL ){
-            for( i = 0; i < counterOnG4[t]; i++ ){
-                int ri = recvIdxOnG4[t][i];
-                for( int dim = 0; dim < varDim; dim++ ){
-                    densVel[varDim*ri+dim] = recvBuf[t][varDim*i+dim];
+            
+            for( int side = 0; side < 2; side++ ){
+                if( counts[side] == 1 ){
+                    MPI_Type_free(&types[side]);
                 }
             }
         }
     }
+}
+
+
+//  halo of smoothed variables, ghosts on sides without neighbour included
+void GridManager::exchangeSmoothed(const vector<int>& varNames){
+    if( loader->haloExchangeType == FACE_STAGED_EXCHANGE ){
+        for( int stage = 0; stage < 3; stage++ ){
+            sendRecvOnG2(varNames, HALO_G2_SMOOTHED, stage, nullptr);
+        }
+    }else{
+        sendRecvOnG2(varNames, HALO_G2_SMOOTHED, ALL_NEIGHBORS, nullptr);
+    }
+}
+
+
+void GridManager::smooth(int varName){
+    vector<int> varNames = {varName};
+    smooth(varNames);
+}
+
+
+//  smoothIterations passes of the filter over all listed variables, each
+//  pass (or each width-1 passes with deep ghost layers) followed by one
+//  halo exchange for all of them; BC between passes, the last one is
+//  left to the caller
+void GridManager::smooth(vector<int> varNames){
     
+    auto start_time = high_resolution_clock::now();
+    string varsStr = "";
     
-    for (t = 0; t < 27; t++) {
-        delete [] sendBuf[t];
-        delete [] recvBuf[t];
-    }
-    
-    
-    
-    
-    
-    /*
-     *                           |               |               |
-     *                                           |
-     *                  (i-1,j+1).B______________A.(i,j+1)________.B(i+1,j+1)
-     *                           .               |               .
-     *                           |               |               |
-     *                           .               |               .
-     *                                           |               |
-     *                           .               |               .
-     *                           |               |               |
-     *                           .               |               .
-     *                           |               |               |
-     *                   A(i-1,j) ._______________O.(i,j)___________.A(i+1,j)
-     *                           |               |               |
-     *                           .               |               .
-     *                           |               |               |
-     *                                           |               .
-     *                           |               |               |
-     *                           .               |               .
-     *                           |               |               |
-     *                           .               |               .
-     *                  (i-1,j-1)B.______________A.(i,j-1)________.B(i+1,j-1)
-     *                               
-     */
-
-
-    int zeroOrderNeighb[6][3]  =
-       {{-1,0 ,0 }, {+1,0 ,0 },
-        {0 ,-1,0 }, {0 ,+1,0 },
-        {0 ,0 ,-1}, {0 ,0 ,+1}};
-    
-    int firstOrderNeighb[12][3] =
-       {{-1,-1, 0}, {-1,+1, 0},
-        {-1,0 ,-1}, {-1,0 ,+1},
-        {0 ,-1,-1}, {0 ,-1,+1},
-        {0 ,+1,-1}, {0 ,+1,+1},
-        {+1,0 ,-1}, {+1,0 ,+1},
-        {+1,-1, 0}, {+1,+1, 0}};
-    
-    int secndOrderNeighb[8][3] =
-       {{-1,-1,-1}, {-1,-1,+1},
-        {-1,+1,-1}, {-1,+1,+1},
-        {+1,-1,-1}, {+1,-1,+1},
-        {+1,+1,-1}, {+1,+1,+1}};
-    
-    const double k2 = 0.125;
-    const double k3 = 0.0625;
-    const double k4 = 0.03125;
-    const double k5 = 0.015625;
-    
-    int foi, soi, toi;
-    int idxFo, idxSo, idxTo;
-    
-    for( i = 1; i < xResG2+1; i++ ){
-        for( j = 1; j < yResG2+1; j++ ){
-            for( k = 1; k < zResG2+1; k++ ){
-                
-                idxG4 = IDX(i, j, k, xResG4, yResG4, zResG4);
-                
-                double smoothedVal[4] = {0.0,0.0,0.0,0.0};
-                
-                for( int dim = 0; dim < varDim; dim++ ){
-                    
-                    smoothedVal[dim] = k2*densVel[varDim*idxG4+dim];
-                    
-                    for( foi = 0; foi < 6; foi++ ){
-                        idxFo = IDX(i+zeroOrderNeighb[foi][0],
-                                    j+zeroOrderNeighb[foi][1],
-                                    k+zeroOrderNeighb[foi][2],
-                                    xResG4,yResG4,zResG4);
-                        smoothedVal[dim] += k3*densVel[varDim*idxFo+dim];
-                    }
-                
-                    for( soi = 0; soi < 12; soi++ ){
-                        idxSo = IDX(i+firstOrderNeighb[soi][0],
-                                    j+firstOrderNeighb[soi][1],
-                                    k+firstOrderNeighb[soi][2],
-                                    xResG4,yResG4,zResG4);
-                        smoothedVal[dim] += k4*densVel[varDim*idxSo+dim];
-                    }
-               
-                    for( toi = 0; toi < 8; toi++ ){
-                        idxTo = IDX(i+secndOrderNeighb[toi][0],
-                                    j+secndOrderNeighb[toi][1],
-                                    k+secndOrderNeighb[toi][2],
-                                    xResG4,yResG4,zResG4);
-                        smoothedVal[dim] += k5*densVel[varDim*idxTo+dim];
-                    }
-                    
-                }
-                
-                idx = IDX(i-1, j-1, k-1, xResG2, yResG2, zResG2);
-                nodesG2vars[G2nodesNumber*DENSELEC+idx]->setValue(0, smoothedVal[0]);
-                
-                for( int dim = 1; dim < varDim; dim++ ){
-                    nodesG2vars[G2nodesNumber*VELOCION+idx]->setValue(dim-1, smoothedVal[dim]);
-                }
-            }
-        }
+    for( int v = 0; v < varNames.size(); v++ ){
+        varsStr += to_string(varNames[v])+" ";
+    }
+    
+    smoothPasses(varNames, 0);
+    for( int v = 0; v < varNames.size(); v++ ){
+        invalidateDerivedOnG2(varNames[v]);
     }
     
-    delete [] densVel;
     auto end_time = high_resolution_clock::now();
-    string msg ="[GridManager] smooth N V duration = "
-                +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    string msg ="[GridManager] smooth vars = "+varsStr
+                +" duration = "+to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
     logger->writeMsg(msg.c_str(), DEBUG);
+    
+}
+
+
+//  passes from firstIter on, the grid holds the result of the previous ones
+void GridManager::smoothPasses(const vector<int>& varNames, int firstIter){
+    
+    int passesPerExchange = max(smoothGhostWidth-1, 1);
+    
+    for( int iter = firstIter; iter < loader->smoothIterations; iter += passesPerExchange ){
+        if( iter > 0 ){
+            for( int v = 0; v < varNames.size(); v++ ){
+                applyBC(varNames[v]);
+            }
+        }
+        if( smoothGhostWidth > 1 ){
+            smoothWithGhosts(varNames, min(passesPerExchange,
+                                           loader->smoothIterations-iter));
+        }else{
+            smoothInPlace(varNames);
+            exchangeSmoothed(varNames);
+        }
+    }
+}
 
+//  copy of node values in the old VectorVar form, kept for output
+template<int EXTRA>
+static VectorVar getVectorVariableForNode(FieldView<EXTRA> var, int varName, int idx){
+    vector<double> value(var.getSize());
+    for( int dim = 0; dim < var.getSize(); dim++ ){
+        value[dim] = var(idx, dim);
+    }
+    return VectorVar(varName, value);
 }
 
+
 vector<vector<VectorVar>> GridManager::getVectorVariablesForAllNodes(){
     
     int idxG2, idxG1;
@@ -1614,21 +1957,22 @@ vector<vector<VectorVar>> GridManager::getVectorVariablesForAllNodes(){
                     if( stopList.count(varN) ){
                         continue;
                     }
-                    allVars.push_back(*nodesG2vars[G2nodesNumber*varN+idxG2]);
+                    allVars.push_back(getVectorVariableForNode(getFieldOnG2(varN), varN, idxG2));
 		            if (need2Fill == 0) outputVarNames.push_back(humanG2VarNames[varN]);
                 }
-                allVars.push_back(*nodesG1vars[G1nodesNumber*MAGNETIC+idxG1]);
+                allVars.push_back(getVectorVariableForNode(getFieldOnG1(MAGNETIC), MAGNETIC, idxG1));
  		        if (need2Fill == 0) outputVarNames.push_back("b");
 
                 #ifdef USE_COLLISIONAL_RESIST_FACTOR
-                    allVars.push_back(*nodesG2vars[G2nodesNumber*RESISTIVITY+idxG2]);
+                    allVars.push_back(getVectorVariableForNode(getFieldOnG2(RESISTIVITY), RESISTIVITY, idxG2));
  		            if (need2Fill == 0) outputVarNames.push_back("eta");
                 #endif
 
                 #ifdef GET_ION_PRESSURE
                         for( type = 0; type < numOfSpecies; type++ ){
                             if( loader->getIfSpeciesFrozen(type) == 0 ){
-                                allVars.push_back(*nodesG2vars[G2nodesNumber*ION_PRESSURE(type)+idxG2]);
+                                allVars.push_back(getVectorVariableForNode(getFieldOnG2(ION_PRESSURE(type)),
+                                                                           ION_PRESSURE(type), idxG2));
                                 if (need2Fill == 0) outputVarNames.push_back("pi"+to_string(type+1));
                             }
                         }                    
@@ -1648,34 +1992,200 @@ vector<string> GridManager::getHumanReadableOutputVarNames(){
 }
 
 
+//  VectorVar setters are kept for the initialisation code
 void GridManager::setVectorVariableForNodeG1(int idx, VectorVar variable){
-    nodesG1vars[G1nodesNumber*variable.getName()+idx]->setValue(variable.getValue());
+    FieldG1 var = getFieldOnG1(variable.getName());
+    for( int dim = 0; dim < var.getSize(); dim++ ){
+        var(idx, dim) = variable.getValue()[dim];
+    }
+    invalidateDerivedOnG1(variable.getName());
 }
 
 
 void GridManager::setVectorVariableForNodeG2(int idx, VectorVar variable){
-    nodesG2vars[G2nodesNumber*variable.getName()+idx]->setValue(variable.getValue());
+    FieldG2 var = getFieldOnG2(variable.getName());
+    for( int dim = 0; dim < var.getSize(); dim++ ){
+        var(idx, dim) = variable.getValue()[dim];
+    }
+    invalidateDerivedOnG2(variable.getName());
 }
 
+//  the node setters drop the derived fields of what they write themselves
 void GridManager::setVectorVariableForNodeG2(int idx, int name, int dim, double value){
-    nodesG2vars[G2nodesNumber*name+idx]->setValue(dim, value);
+    fieldsG2[strideG2*(firstCompG2[name]+dim)+idx] = value;
+    invalidateDerivedOnG2(name);
 }
 
 void GridManager::setVectorVariableForNodeG1(int idx, int name, int dim, double value){
-    nodesG1vars[G1nodesNumber*name+idx]->setValue(dim, value);
+    fieldsG1[strideG1*(firstCompG1[name]+dim)+idx] = value;
+    invalidateDerivedOnG1(name);
 }
 
 void GridManager::addVectorVariableForNodeG2(int idx, int name, int dim, double value){
-    nodesG2vars[G2nodesNumber*name+idx]->addValue(dim, value);
+    fieldsG2[strideG2*(firstCompG2[name]+dim)+idx] += value;
+    invalidateDerivedOnG2(name);
+}
+
+
+FieldG1 GridManager::getFieldOnG1(int varName){
+    return FieldG1(fieldsG1+strideG1*firstCompG1[varName], varSizeG1[varName], strideG1);
+}
+
+
+FieldG2 GridManager::getFieldOnG2(int varName){
+    return FieldG2(fieldsG2+strideG2*firstCompG2[varName], varSizeG2[varName], strideG2);
+}
+
+
+//  all nodes of all components of varFrom into varTo: components of a
+//  variable are consecutive in the storage, so it is one block copy
+void GridManager::copyFieldOnG2(int varFrom, int varTo){
+    if( varSizeG2[varFrom] != varSizeG2[varTo] ){
+        throw runtime_error("variables of different size can not be copied");
+    }
+    const double* from = fieldsG2+strideG2*firstCompG2[varFrom];
+    copy(from, from+strideG2*varSizeG2[varFrom], fieldsG2+strideG2*firstCompG2[varTo]);
+    invalidateDerivedOnG2(varTo);
+}
+
+
+//  copy of all variables on G1 and G2, halos have to be flushed before,
+//  so that nothing posted is lost on restore
+void GridManager::saveState(){
+    long compsG1 = firstCompG1[totVarsOnG1-1]+varSizeG1[totVarsOnG1-1];
+    long compsG2 = firstCompG2[totVarsOnG2-1]+varSizeG2[totVarsOnG2-1];
+    savedFieldsG1.assign(fieldsG1, fieldsG1+strideG1*compsG1);
+    savedFieldsG2.assign(fieldsG2, fieldsG2+strideG2*compsG2);
+}
+
+
+void GridManager::restoreState(){
+    if( savedFieldsG1.empty() ){
+        throw runtime_error("no saved field storage to restore!");
+    }
+    copy(savedFieldsG1.begin(), savedFieldsG1.end(), fieldsG1);
+    copy(savedFieldsG2.begin(), savedFieldsG2.end(), fieldsG2);
+    
+    pendingHaloVars.clear();
+    pendingHaloSmooth.clear();
+    fill(derivedValid, derivedValid+SIZE_DERIVED, false);
+}
+
+
+//  derived quantity, recomputed only if an input was written since
+//  the last request. The node setters, copyFieldOnG2, applyBC and smooth
+//  report their writes themselves, a kernel writing an input through a
+//  FieldG1/FieldG2 view has to call invalidateDerivedOnG1/G2 once it is
+//  done; build with -DCHECK_DERIVED_FIELDS to catch a missing call
+FieldG2 GridManager::getDerivedField(int derivedName){
+    if( derivedValid[derivedName] ){
+#ifdef CHECK_DERIVED_FIELDS
+        checkDerivedField(derivedName);
+#endif
+        derivedReused++;
+    }else{
+        calculateDerivedField(derivedName);
+        derivedValid[derivedName] = true;
+        derivedComputed++;
+    }
+    return FieldG2(derivedFields+strideG2*firstCompDerived[derivedName],
+                   derivedSize[derivedName], strideG2);
+}
+
+
+//  writers of an input report it here, the magnetic field kernels write
+//  through views and call it once the field is final
+void GridManager::invalidateDerivedOnG1(int varName){
+    switch (varName) {
+        case MAGNETIC:
+            derivedValid[CELL_MAGNETIC] = false;
+            break;
+        case MAGNETIC_AUX:
+            derivedValid[CELL_MAGNETIC_AUX] = false;
+            break;
+    }
+}
+
+
+void GridManager::invalidateDerivedOnG2(int varName){
+    if( varName == DENSELEC ){
+        derivedValid[REVERT_DENSITY] = false;
+    }
+}
+
+
+//  a reused field has to be equal to the one recomputed from the inputs,
+//  otherwise an input was written without invalidating it
+void GridManager::checkDerivedField(int derivedName){
+    double* first = derivedFields+strideG2*firstCompDerived[derivedName];
+    vector<double> cached(first, first+strideG2*derivedSize[derivedName]);
+    calculateDerivedField(derivedName);
+    if( !equal(cached.begin(), cached.end(), first) ){
+        string msg = "[GridManager] derived field "+to_string(derivedName)
+                     +" is stale, an input was written without invalidation";
+        logger->writeMsg(msg.c_str(), CRITICAL);
+        throw runtime_error(msg);
+    }
 }
 
 
-VectorVar** GridManager::getVectorVariableOnG1(int varName){
-    return &nodesG1vars[G1nodesNumber*varName];
+long GridManager::getDerivedComputed(){
+    return derivedComputed;
 }
 
 
-VectorVar** GridManager::getVectorVariableOnG2(int varName){
-     return &nodesG2vars[G2nodesNumber*varName];
+long GridManager::getDerivedReused(){
+    return derivedReused;
 }
 
+
+void GridManager::calculateDerivedField(int derivedName){
+    
+    int xRes = loader->resolution[0],
+        yRes = loader->resolution[1],
+        zRes = loader->resolution[2];
+    int i, j, k, idxG1, idxG2, coord, vertex;
+    double sum;
+    
+    FieldG2 derived(derivedFields+strideG2*firstCompDerived[derivedName],
+                    derivedSize[derivedName], strideG2);
+    
+    switch (derivedName) {
+        case CELL_MAGNETIC:
+        case CELL_MAGNETIC_AUX:{
+            FieldG1 bField = getFieldOnG1(derivedName == CELL_MAGNETIC ? MAGNETIC : MAGNETIC_AUX);
+            int strides[3], cellVertices[8];
+            getNodeStrides(1, 1, strides);
+            stencilOffsets(CELL_VERTICES, strides, cellVertices);
+            
+            for( coord = 0; coord < 3; coord++ ){
+                const double* B = bField.getComponent(coord);
+                double* cellB   = derived.getComponent(coord);
+                for( i = 1; i < xRes+1; i++ ){
+                    for( j = 1; j < yRes+1; j++ ){
+                        for( k = 1; k < zRes+1; k++ ){
+                            idxG1 = IDX(i, j, k, xRes+1, yRes+1, zRes+1);
+                            idxG2 = IDX(i, j, k, xRes+2, yRes+2, zRes+2);
+                            sum = 0.0;
+                            for( vertex = 0; vertex < 8; vertex++ ){
+                                sum += 0.125*B[idxG1+cellVertices[vertex]];
+                            }
+                            cellB[idxG2] = sum;
+                        }
+                    }
+                }
+            }
+            break;
+        }
+        case REVERT_DENSITY:{
+            const double* dens = getFieldOnG2(DENSELEC).getComponent(0);
+            double* revert     = derived.getComponent(0);
+            for( idxG2 = 0; idxG2 < G2nodesNumber; idxG2++ ){
+                revert[idxG2] = dens[idxG2] < EPS8 ? 0.0 : edgeProfile(dens[idxG2])/dens[idxG2];
+            }
+            break;
+        }
+        default:
+            throw runtime_error("no derived field");
+    }
+}
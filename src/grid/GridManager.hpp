@@ -1,6 +1,7 @@
 #ifndef GridManager_hpp
 #define GridManager_hpp
 #include <stdio.h>
+#include <stdlib.h>
 #include <vector>
 #include <map>
 #include <set>
@@ -8,12 +9,18 @@
 #include <memory>
 #include <chrono>
 #include <algorithm>
+#include <new>
 #include <mpi.h>
 #include "../misc/Logger.hpp"
+#include "../misc/Workspace.hpp"
+#include "../misc/Threads.hpp"
 #include "../misc/Misc.hpp"
 #include "../input/Loader.hpp"
 
 #include "../common/variables/VectorVar.hpp"
+#include "../common/variables/FieldView.hpp"
+#include "Stencil.hpp"
+#include "Tiling.hpp"
 
 
 enum G1VAR{
@@ -41,6 +48,28 @@ enum G2VAR{
     SIZEG2
 };
 
+//# quantities derived from grid variables on G2: computed on the first
+//# request and kept until one of their inputs is written.
+//# CELL_MAGNETIC(_AUX) - 8-vertex average of MAGNETIC(_AUX) in the cells
+//# 1..res, REVERT_DENSITY - edgeProfile(n)/n of DENSELEC, 0 in vacuum
+enum DERIVED_VAR{
+    CELL_MAGNETIC,
+    CELL_MAGNETIC_AUX,
+    REVERT_DENSITY,
+    SIZE_DERIVED
+};
+
+//# halo regions: copy into G2 ghosts, gather (add) 2-wide slabs on G2,
+//# copy after smoothing (with the ghosts of sides without neighbour)
+enum HALO_TYPE{
+    HALO_G2,
+    HALO_G2_GATHER,
+    HALO_G2_SMOOTHED
+};
+
+#define ALL_NEIGHBORS -1
+#define MAX_VAR_DIM 6
+
 //# for boundary conditions
 #define NEIGHBOR_LEFT   4
 #define NEIGHBOR_RIGHT  22
@@ -49,6 +78,39 @@ enum G2VAR{
 #define NEIGHBOR_BACK   12
 #define NEIGHBOR_FRONT  14
 
+//# data of another exchange carried by a halo message, counts in doubles
+struct HaloPayload{
+    double* sendBuf[27];
+    int     sendCount[27];
+    double* recvBuf[27];
+    int     recvCapacity[27];
+    int     recvCount[27];
+};
+
+//# ghost layer copy of the same value BC: blocksNum blocks of blockLen
+//# contiguous nodes, blockStride apart, from the layer at src to dst
+struct BoundarySlab{
+    long src;
+    long dst;
+    long blockLen;
+    long blocksNum;
+    long blockStride;
+};
+
+//# ghost-extended block of the smoothing workspace: components of the
+//# variables one after another, node (i, j, k) of the G2 block at
+//# (i+lo-1, j+lo-1, k+lo-1), lo ghost layers before the first interior node
+struct GhostedBlock{
+    std::vector<int> varNames;
+    int lo[3];
+    int n[3];
+    long nodesNum;
+    int totDim;
+    //# borrowed from the workspace until the block is smoothed
+    double* work;
+    long workspaceMark;
+};
+
 class GridManager{
     
     
@@ -56,6 +118,7 @@ private:
     
     std::unique_ptr<Logger> logger;
     std::shared_ptr<Loader> loader;
+    std::shared_ptr<Workspace> workspace;
     
     
     int NUM_OF_MAIN_G2VARS = SIZEG2;
@@ -74,59 +137,104 @@ private:
     std::vector<std::string> outputVarNames;
     std::vector<std::string> humanG2VarNames;
     
-    VectorVar** nodesG1vars;
-    VectorVar** nodesG2vars;
-    
-    int* neibors4G2spatialDerX;
-    int* neibors4G2spatialDerY;
-    int* neibors4G2spatialDerZ;
+    //# one aligned array per (variable, component), variable v starts
+    //# at component firstComp[v], components are stride doubles apart
+    double* fieldsG1;
+    double* fieldsG2;
+    long strideG1;
+    long strideG2;
+    std::vector<int> varSizeG1, firstCompG1;
+    std::vector<int> varSizeG2, firstCompG2;
+    
+    //# derived quantities, same layout as the G2 storage
+    double* derivedFields;
+    int derivedSize[SIZE_DERIVED] = {3, 3, 1};
+    int firstCompDerived[SIZE_DERIVED];
+    bool derivedValid[SIZE_DERIVED] = {false, false, false};
+    long derivedComputed = 0;
+    long derivedReused = 0;
+    void calculateDerivedField(int);
+    void checkDerivedField(int);
+    
+    //# applied in order: x faces, then y and z faces, so that
+    //# edge and corner ghosts are set from already filled layers
+    std::vector<BoundarySlab> boundarySlabs;
+    
+    //# halo slabs {send from, send to, recv from, recv to} per axis,
+    //# indexed by scheme (0 - 26 neighbours, 1 - faces), HALO_TYPE, neighbour
+    int haloRange[2][3][27][3][4];
+    
+    //# committed slab datatypes (components stride apart),
+    //# last index is the variable size
+    MPI_Datatype haloSendType[2][3][27][MAX_VAR_DIM+1];
+    MPI_Datatype haloRecvType[2][3][27][MAX_VAR_DIM+1];
+    std::vector<MPI_Datatype> haloTypes;
+    
+    //# G2 storage in a shared window, slabs of on-node neighbours
+    //# are read from their storage instead of being sent
+    MPI_Win nodeWin = MPI_WIN_NULL;
+    double* nodeNeighborStore[27] = {nullptr};
+    int nodeNeighborRes[27][3];
+    
+    //# posted copy halos waiting for the next communication round
+    std::vector<int> pendingHaloVars;
+    std::vector<int> pendingHaloSmooth;
+    int commRoundsSaved = 0;
+    
+    //# copy of the field storage to roll a rejected timestep back
+    std::vector<double> savedFieldsG1;
+    std::vector<double> savedFieldsG2;
     
-    int* negbors4PresX;
-    int* negbors4PresY;
-    int* negbors4PresZ;
-    
-    int* negbors4LaplacX;
-    int* negbors4LaplacY;
-    int* negbors4LaplacZ;
-    
-    int* neibors4G1spatialDerX;
-    int* neibors4G1spatialDerY;
-    int* neibors4G1spatialDerZ;
-    
-    std::map<int, int> idxs4BoundaryX2fill;
-    std::map<int, int> idxs4BoundaryY2fill;
-    std::map<int, int> idxs4BoundaryZ2fill;
-    
-    int* neighbourhood;
+    void initialize();
     
-    int counter[27], counter4Gath[27], counterOnG4[27];
+    void initFieldStorage();
     
-    int* sendIdx[27];
-    int* recvIdx[27];
+    void getHaloSlab(int, int, int, int[4]);
+    void initHaloRanges();
+    void initHaloDatatypes();
+    void initSharedStorage();
+    void readNodeNeighbor(const std::vector<int>&, int, int, int, double*);
+    void checkFaceExchange();
     
-    int* sendIdx4Gath[27];
-    int* recvIdx4Gath[27];
+    std::vector<int> getNeighbors4Stage(int);
+    void sendRecvOnG2(const std::vector<int>&, int, int, HaloPayload*);
+    MPI_Datatype createSlabsType(const std::vector<int>&,
+                                 MPI_Datatype[27][MAX_VAR_DIM+1], int);
     
-    int* sendIdxOnG4[27];
-    int* recvIdxOnG4[27];
+    //# copy halo in flight while the inner nodes are computed
+    std::vector<int> haloVarsInFlight;
+    std::vector<MPI_Request> haloRequests;
+    std::chrono::high_resolution_clock::time_point haloStartTime;
+    double haloOverlapTime = 0.0;
+    double haloWaitTime = 0.0;
     
-    void initialize();
+    void initBoundarySlabs();
     
-    void initG1Nodes();
-    void initG2Nodes();
+    void smoothInPlace(const std::vector<int>&);
+    void exchangeSmoothed(const std::vector<int>&);
     
-    void sendRecvIndecis4MPI();
-    void sendRecvIndecis4MPIext();
-    void sendRecvIndecis4MPIonG4();
+    //# ghost layers of the smoothing workspace on the sides with neighbour,
+    //# 1 - smoothing in place with one exchange per pass
+    int smoothGhostWidth = 1;
+    void initSmoothGhostWidth();
     
-    void initBoundaryIndecies();
+    //# committed ghost slab datatypes of one component of the workspace,
+    //# indexed by scheme (0 - 26 neighbours, 1 - faces) and neighbour
+    MPI_Datatype ghostSendType[2][27];
+    MPI_Datatype ghostRecvType[2][27];
+    void initGhostDatatypes();
     
-    void fillG4Boundary4outflowBC(double* , int );
+    void getGhostedBlockSize(int[3], int[3]);
+    void smoothWithGhosts(const std::vector<int>&, int);
+    void initGhostedBlock(const std::vector<int>&, GhostedBlock&);
+    void filterGhostedBlock(GhostedBlock&, int);
+    void exchangeGhosts(GhostedBlock&);
+    void smoothPasses(const std::vector<int>&, int);
     
     
 public:
     
-    GridManager(std::shared_ptr<Loader>);
+    GridManager(std::shared_ptr<Loader>, std::shared_ptr<Workspace>);
     ~GridManager();
    
     int DENS_AUX(int);
@@ -135,24 +243,22 @@ public:
     
     int getVarsNumOnG2();
     int getVarsNumOnG1();
-    const int* getNghbd4LaplacInXonG2();
-    const int* getNghbd4LaplacInYonG2();
-    const int* getNghbd4LaplacInZonG2();
-    
-    const int* getNghbd4DivPeInXonG2();
-    const int* getNghbd4DivPeInYonG2();
-    const int* getNghbd4DivPeInZonG2();
-    
-    const int* getNeibors4G2spatialDerX();
-    const int* getNeibors4G2spatialDerY();
-    const int* getNeibors4G2spatialDerZ();
-    
-    const int* getNeibors4G1spatialDerX();
-    const int* getNeibors4G1spatialDerY();
-    const int* getNeibors4G1spatialDerZ();
-    
-    VectorVar** getVectorVariableOnG1(int);
-    VectorVar** getVectorVariableOnG2(int);
+    void getNodeStrides(int, int, int[3]);
+    std::vector<Tile> getTiles(int, int);
+    std::vector<Tile> getShellFirstTiles(int, int, int&);
+    std::vector<int> getNodeOrder(int, int);
+    int getGridDimension();
+    
+    FieldG1 getFieldOnG1(int);
+    FieldG2 getFieldOnG2(int);
+    void copyFieldOnG2(int, int);
+    void saveState();
+    void restoreState();
+    FieldG2 getDerivedField(int);
+    void invalidateDerivedOnG1(int);
+    void invalidateDerivedOnG2(int);
+    long getDerivedComputed();
+    long getDerivedReused();
     std::vector<std::vector<VectorVar>> getVectorVariablesForAllNodes();
     std::vector<std::string> getHumanReadableOutputVarNames();
     
@@ -165,14 +271,25 @@ public:
     void setVectorVariableForNodeG2(int , int , int, double);
     void addVectorVariableForNodeG2(int , int , int, double);
     
-    const int* getNeighbourhoodOnG1();
-    
     void sendBoundary2Neighbor(int);
+    void sendBoundary2Neighbor(std::vector<int>);
+    void startBoundary2Neighbor(std::vector<int>);
+    void finishBoundary2Neighbor(std::vector<int>);
+    double getHaloOverlapTime();
+    double getHaloWaitTime();
+    void postBoundary2Neighbor(int, int);
+    int  getPendingHalosNum();
+    bool isHaloPending(int);
+    void flushHalos(HaloPayload*);
+    int  getCommRoundsSaved();
     void gatherBoundaryUsingNeighbor(int);
+    void gatherBoundaryUsingNeighbor(std::vector<int>);
     void applyBC(int);
     
-    void smoothDensAndIonVel();
     void smooth(int);
+    void smooth(std::vector<int>);
+    bool openGhostedBlock(const std::vector<int>&, GhostedBlock&);
+    void smoothGhostedBlock(GhostedBlock&);
     
 };
 #endif /* GridManager_hpp */
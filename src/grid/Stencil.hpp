@@ -0,0 +1,73 @@
+#ifndef Stencil_hpp
+#define Stencil_hpp
+
+#include <stdio.h>
+
+//  stencils are unit offsets {di, dj, dk} from the central node,
+//  node index of a point is idx + di*strides[0] + dj*strides[1] + dk*strides[2].
+//  With the stride of a collapsed axis (resolution 1) set to 0 the same
+//  stencil serves 1D, 2D and 3D runs: points along that axis fall on the node.
+
+//  8 vertices on G1 of the cell whose centre on G2 has the same (i, j, k)
+static const int CELL_VERTICES[8][3] =
+   {{ 0, 0, 0}, { 0, 0,-1}, { 0,-1, 0}, {-1, 0, 0},
+    { 0,-1,-1}, {-1,-1, 0}, {-1, 0,-1}, {-1,-1,-1}};
+
+//  pairs {+, -} of the derivative along x, y and z between G1 and G2 used in
+//  the curls: G2 points around the G1 node with the same (i, j, k), or with
+//  negated strides, G1 points around the G2 node with the same (i, j, k)
+static const int CURL_PAIRS[3][8][3] =
+   {{{ 1, 0, 0}, { 0, 0, 0}, { 1, 1, 0}, { 0, 1, 0},
+     { 1, 0, 1}, { 0, 0, 1}, { 1, 1, 1}, { 0, 1, 1}},
+
+    {{ 0, 1, 0}, { 0, 0, 0}, { 1, 1, 0}, { 1, 0, 0},
+     { 0, 1, 1}, { 0, 0, 1}, { 1, 1, 1}, { 1, 0, 1}},
+
+    {{ 0, 0, 1}, { 0, 0, 0}, { 1, 0, 1}, { 1, 0, 0},
+     { 0, 1, 1}, { 0, 1, 0}, { 1, 1, 1}, { 1, 1, 0}}};
+
+//  pairs {+, -} of the derivative along x, y and z on G2 used in div P:
+//  weights are 0.125 for pairs 0-3, 0.25 for pairs 4-7 and 0.5 for pair 8
+static const int DIV_P_PAIRS[3][18][3] =
+   {{{ 1, 1,-1}, {-1, 1,-1}, { 1,-1,-1}, {-1,-1,-1},
+     { 1, 1, 1}, {-1, 1, 1}, { 1,-1, 1}, {-1,-1, 1},
+     { 1, 0,-1}, {-1, 0,-1}, { 1, 1, 0}, {-1, 1, 0},
+     { 1,-1, 0}, {-1,-1, 0}, { 1, 0, 1}, {-1, 0, 1},
+     { 1, 0, 0}, {-1, 0, 0}},
+
+    {{ 1, 1,-1}, { 1,-1,-1}, {-1, 1,-1}, {-1,-1,-1},
+     { 1, 1, 1}, { 1,-1, 1}, {-1, 1, 1}, {-1,-1, 1},
+     { 0, 1,-1}, { 0,-1,-1}, { 1, 1, 0}, { 1,-1, 0},
+     {-1, 1, 0}, {-1,-1, 0}, { 0, 1, 1}, { 0,-1, 1},
+     { 0, 1, 0}, { 0,-1, 0}},
+
+    {{ 1,-1, 1}, { 1,-1,-1}, {-1,-1, 1}, {-1,-1,-1},
+     { 1, 1, 1}, { 1, 1,-1}, {-1, 1, 1}, {-1, 1,-1},
+     { 0,-1, 1}, { 0,-1,-1}, { 1, 0, 1}, { 1, 0,-1},
+     {-1, 0, 1}, {-1, 0,-1}, { 0, 1, 1}, { 0, 1,-1},
+     { 0, 0, 1}, { 0, 0,-1}}};
+
+//  index offsets of the stencil points for the given node strides
+template<int N>
+inline void stencilOffsets(const int (&stencil)[N][3], const int strides[3], int offsets[N]){
+    for( int n = 0; n < N; n++ ){
+        offsets[n] = stencil[n][0]*strides[0]
+                    +stencil[n][1]*strides[1]
+                    +stencil[n][2]*strides[2];
+    }
+}
+
+//  offsets of the pairs of a derivative, derivative along a collapsed axis
+//  vanishes: both points of every pair fall on the node
+template<int N>
+inline void derivativeOffsets(const int (&pairs)[N][3], const int strides[3],
+                              int collapsed, int offsets[N]){
+    stencilOffsets(pairs, strides, offsets);
+    if( collapsed ){
+        for( int n = 0; n < N; n++ ){
+            offsets[n] = 0;
+        }
+    }
+}
+
+#endif /* Stencil_hpp */
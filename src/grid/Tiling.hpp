@@ -0,0 +1,63 @@
+#ifndef Tiling_hpp
+#define Tiling_hpp
+
+#include <stdio.h>
+#include <vector>
+#include <algorithm>
+
+//  block of nodes from[e] <= i_e < to[e] swept by a grid kernel at once,
+//  small enough that all inputs of the stencil around it stay in cache.
+//  A kernel visits the nodes of a tile in the usual i, j, k order, so
+//  kernels with no dependence between nodes give the same result for any
+//  tiling, and independent stages can be run one after another per tile
+struct Tile{
+    int from[3];
+    int to[3];
+};
+
+//  tiles of at most size[e] nodes along axis e covering the box [from, to),
+//  size[e] < 1 keeps the whole extent; tiles follow the node order
+inline std::vector<Tile> makeTiles(const int from[3], const int to[3], const int size[3]){
+
+    std::vector<Tile> tiles;
+    int step[3];
+
+    for( int e = 0; e < 3; e++ ){
+        if( to[e] <= from[e] ){
+            return tiles;
+        }
+        step[e] = size[e] < 1 ? to[e] - from[e] : size[e];
+    }
+
+    Tile tile;
+    for( int i = from[0]; i < to[0]; i += step[0] ){
+        for( int j = from[1]; j < to[1]; j += step[1] ){
+            for( int k = from[2]; k < to[2]; k += step[2] ){
+                tile.from[0] = i;
+                tile.from[1] = j;
+                tile.from[2] = k;
+                tile.to[0] = std::min(i+step[0], to[0]);
+                tile.to[1] = std::min(j+step[1], to[1]);
+                tile.to[2] = std::min(k+step[2], to[2]);
+                tiles.push_back(tile);
+            }
+        }
+    }
+    return tiles;
+}
+
+//  key of node (i, j, k) on the Morton (Z-order) curve: bits of the three
+//  indices interleaved, so nodes close along any axis get close keys
+inline unsigned long long mortonKey(int i, int j, int k){
+    
+    unsigned long long key = 0;
+    
+    for( int bit = 0; bit < 21; bit++ ){
+        key |= ((unsigned long long)((i >> bit) & 1) << (3*bit+2))
+             | ((unsigned long long)((j >> bit) & 1) << (3*bit+1))
+             | ((unsigned long long)((k >> bit) & 1) << (3*bit));
+    }
+    return key;
+}
+
+#endif /* Tiling_hpp */
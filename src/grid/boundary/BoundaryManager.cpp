@@ -3,7 +3,11 @@
 using namespace std;
 using namespace chrono;
 
-BoundaryManager::BoundaryManager(shared_ptr<Loader> ldr):loader(move(ldr)){
+BoundaryManager::BoundaryManager(shared_ptr<Loader> ldr,
+                                 shared_ptr<GridManager> gridMnr,
+                                 shared_ptr<Workspace> wrkspc):loader(move(ldr)),
+                                                               gridMgr(move(gridMnr)),
+                                                               workspace(move(wrkspc)){
     logger.reset(new Logger());
     initialize();
     string msg ="[BoundaryManager] init...OK";
@@ -11,18 +15,33 @@ BoundaryManager::BoundaryManager(shared_ptr<Loader> ldr):loader(move(ldr)){
 }
 
 
+BoundaryManager::~BoundaryManager(){
+    for( int t = 0; t < 27; t++ ){
+        delete [] recvBufs[t];
+    }
+}
+
+
 
 void BoundaryManager::initialize(){
     logger->writeMsg("[BoundaryManager] initialize() ...", DEBUG);
     leavingParticles.reserve(NUM_OF_LEAVING_PACTICLES);
     for( int t = 0; t < 27; t++ ){
         domain2send[t] = 0;
+        recvBufs[t] = nullptr;
+    }
+    //# receive buffers only for the directions with a neighbour, they are
+    //# kept for the whole run: pages are touched only by the particles received
+    for( int n = 0; n < loader->haloNeighbors.size(); n++ ){
+        recvBufs[loader->haloNeighbors[n]] = new double[EXPECTED_NUM_OF_PARTICLES*PARTICLES_SIZE];
     }
     logger->writeMsg("[BoundaryManager] initialize() ...OK", DEBUG);
 }
 
 
 
+//  neighbour direction is found only along the first DIM axes
+template<int DIM>
 int BoundaryManager::isPtclOutOfDomain(double pos[3]){
     
     double domainShiftX = loader->boxCoordinates[0][0];
@@ -42,26 +61,9 @@ int BoundaryManager::isPtclOutOfDomain(double pos[3]){
     y = (pos[1] - domainShiftY)/domainYSize/dy;
     z = (pos[2] - domainShiftZ)/domainZSize/dz;
     
-    switch (loader->dim) {
-        case 1:
-            a = (int)floor(x);
-            b = 0;
-            c = 0;
-            break;
-        case 2:
-            a = (int)floor(x);
-            b = (int)floor(y);
-            c = 0;
-            break;
-        case 3:
-            a = (int)floor(x);
-            b = (int)floor(y);
-            c = (int)floor(z);
-            break;
-            
-        default:
-            throw runtime_error("dimension is not 1/2/3");
-    }
+    a = (int)floor(x);
+    b = DIM > 1 ? (int)floor(y) : 0;
+    c = DIM > 2 ? (int)floor(z) : 0;
     
     t = (1+c)+3*((1+b)+3*(1+a));
     
@@ -123,10 +125,16 @@ void BoundaryManager::applyBC(Particle** particles,
     int partcls2send[27];
     int partcls2recv[27];
     
+    //# send buffers from the workspace, receive buffers are kept
+    WorkspaceScope scope(*workspace);
     for ( t = 0; t < 27; t++ ) {
-        sendBuf[t] = new double[domain2send[t]*PARTICLES_SIZE*sizeof(double)];
-        recvBuf[t] = new double[EXPECTED_NUM_OF_PARTICLES*PARTICLES_SIZE*sizeof(double)];
+        sendBuf[t] = scope.borrow<double>(domain2send[t]*PARTICLES_SIZE);
+        recvBuf[t] = recvBufs[t];
         partcls2send[t] = 0;
+        partcls2recv[t] = 0;
+    }
+    for ( int n = 0; n < loader->haloNeighbors.size(); n++ ) {
+        t = loader->haloNeighbors[n];
         partcls2recv[t] = EXPECTED_NUM_OF_PARTICLES;
     }
 
@@ -222,35 +230,7 @@ void BoundaryManager::applyBC(Particle** particles,
     + " / outflowLeaving = " + to_string(outflowLeaving);
     logger->writeMsg(msd.c_str(), DEBUG);
     
-    MPI_Status st;
-    int receivedTot;
-    for ( t = 0; t < 27; t++ ){
-            if(t != 13){
-                
-                MPI_Sendrecv(sendBuf[t], PARTICLES_SIZE*sizeof(double)*partcls2send[t],
-                             MPI_DOUBLE, loader->neighbors2Send[t], t,
-                             recvBuf[t], PARTICLES_SIZE*sizeof(double)*partcls2recv[t],
-                             MPI_DOUBLE, loader->neighbors2Recv[t], t,
-                             MPI_COMM_WORLD, &st);
-                
-                MPI_Get_count(&st, MPI_DOUBLE, &receivedTot);
-                
-
-                receivedTot = receivedTot/PARTICLES_SIZE/sizeof(double);
-    
-                for (int ptclNum = 0; ptclNum < receivedTot; ptclNum++){
-                    particles2add.push_back(shared_ptr<Particle>(new Particle));
-                    int idxOfAdded = particles2add.size()-1;
-                    particles2add[idxOfAdded]->deserialize(recvBuf[t], PARTICLES_SIZE*ptclNum);
-                }
-                
-            }
-    }
-    
-    for ( t = 0; t < 27; t++ ) {
-                delete [] sendBuf[t];
-                delete [] recvBuf[t];
-    }
+    exchangeParticles(sendBuf, recvBuf, partcls2send, partcls2recv, particles2add);
     
     auto end_time = high_resolution_clock::now();
     string msg ="[BoundaryManager] apply BC duration = "
@@ -292,10 +272,16 @@ void BoundaryManager::applyBC(Particle** particles,
     int partcls2send[27];
     int partcls2recv[27];
     
+    //# send buffers from the workspace, receive buffers are kept
+    WorkspaceScope scope(*workspace);
     for ( t = 0; t < 27; t++ ) {
-        sendBuf[t] = new double[domain2send[t]*PARTICLES_SIZE*sizeof(double)];
-        recvBuf[t] = new double[EXPECTED_NUM_OF_PARTICLES*PARTICLES_SIZE*sizeof(double)];
+        sendBuf[t] = scope.borrow<double>(domain2send[t]*PARTICLES_SIZE);
+        recvBuf[t] = recvBufs[t];
         partcls2send[t] = 0;
+        partcls2recv[t] = 0;
+    }
+    for ( int n = 0; n < loader->haloNeighbors.size(); n++ ) {
+        t = loader->haloNeighbors[n];
         partcls2recv[t] = EXPECTED_NUM_OF_PARTICLES;
     }
 
@@ -376,40 +362,157 @@ void BoundaryManager::applyBC(Particle** particles,
     + " / outflowLeaving = " + to_string(outflowLeaving);
     logger->writeMsg(msd.c_str(), DEBUG);
     
+    exchangeParticles(sendBuf, recvBuf, partcls2send, partcls2recv, particles2add);
+    
+    auto end_time = high_resolution_clock::now();
+    string msg ="[BoundaryManager] apply BC duration = "
+    +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    logger->writeMsg(msg.c_str(),  DEBUG);
+}
+
+
+//  particles for on-node neighbours are put into the shared outbox
+//  and deserialized by the neighbour directly from it,
+//  the others are sent; the order of added particles does not change.
+//  Posted field halos, if any, travel in the same messages
+void BoundaryManager::exchangeParticles(double* sendBuf[27], double* recvBuf[27],
+                                        int partcls2send[27], int partcls2recv[27],
+                                        vector<shared_ptr<Particle>> &particles2add){
+    
+    int t, ptclNum;
+    int sendTo, recvFrom;
+    double* nbOutbox;
+    
+    if( loader->useSharedMemory ){
+        fillOutbox(sendBuf, partcls2send);
+    }
+    
+    bool withHalos = gridMgr->getPendingHalosNum() > 0
+                  && loader->haloExchangeType == ALL_NEIGHBORS_EXCHANGE;
+    
+    HaloPayload payload;
+    if( withHalos ){
+        for( t = 0; t < 27; t++ ){
+            bool onNode = loader->nodeNeighbors2Send[t] != MPI_PROC_NULL;
+            payload.sendBuf[t]      = sendBuf[t];
+            payload.sendCount[t]    = onNode ? 0 : PARTICLES_SIZE*partcls2send[t];
+            payload.recvBuf[t]      = recvBuf[t];
+            payload.recvCapacity[t] = PARTICLES_SIZE*partcls2recv[t];
+            payload.recvCount[t]    = 0;
+        }
+        
+        gridMgr->flushHalos(&payload);
+    }
+    
+    //# particles sent towards a direction without a neighbour are dropped
     MPI_Status st;
     int receivedTot;
-    for ( t = 0; t < 27; t++ ){
-            if(t != 13){
+    for ( int n = 0; n < loader->haloNeighbors.size(); n++ ){
+            t = loader->haloNeighbors[n];
+            if( withHalos ){
                 
-                MPI_Sendrecv(sendBuf[t], PARTICLES_SIZE*sizeof(double)*partcls2send[t],
-                             MPI_DOUBLE, loader->neighbors2Send[t], t,
-                             recvBuf[t], PARTICLES_SIZE*sizeof(double)*partcls2recv[t],
-                             MPI_DOUBLE, loader->neighbors2Recv[t], t,
+                nbOutbox    = recvBuf[t];
+                receivedTot = payload.recvCount[t]/PARTICLES_SIZE;
+                
+                if( loader->nodeNeighbors2Recv[t] != MPI_PROC_NULL ){
+                    MPI_Aint winSize;
+                    int dispUnit;
+                    MPI_Win_shared_query(outboxWin, loader->nodeNeighbors2Recv[t],
+                                         &winSize, &dispUnit, &nbOutbox);
+                    receivedTot = (int) nbOutbox[2*t];
+                    nbOutbox   += (int) nbOutbox[2*t+1];
+                }
+                
+                for (ptclNum = 0; ptclNum < receivedTot; ptclNum++){
+                    particles2add.push_back(shared_ptr<Particle>(new Particle));
+                    int idxOfAdded = particles2add.size()-1;
+                    particles2add[idxOfAdded]->deserialize(nbOutbox, PARTICLES_SIZE*ptclNum);
+                }
+                
+            }else{
+                
+                sendTo   = loader->nodeNeighbors2Send[t] == MPI_PROC_NULL
+                         ? loader->neighbors2Send[t] : MPI_PROC_NULL;
+                recvFrom = loader->nodeNeighbors2Recv[t] == MPI_PROC_NULL
+                         ? loader->neighbors2Recv[t] : MPI_PROC_NULL;
+                
+                MPI_Sendrecv(sendBuf[t], PARTICLES_SIZE*partcls2send[t],
+                             MPI_DOUBLE, sendTo, t,
+                             recvBuf[t], PARTICLES_SIZE*partcls2recv[t],
+                             MPI_DOUBLE, recvFrom, t,
                              MPI_COMM_WORLD, &st);
                 
                 MPI_Get_count(&st, MPI_DOUBLE, &receivedTot);
                 
 
-                receivedTot = receivedTot/PARTICLES_SIZE/sizeof(double);
+                receivedTot = receivedTot/PARTICLES_SIZE;
+                nbOutbox = recvBuf[t];
+                
+                if( recvFrom != loader->neighbors2Recv[t] ){
+                    MPI_Aint winSize;
+                    int dispUnit;
+                    MPI_Win_shared_query(outboxWin, loader->nodeNeighbors2Recv[t],
+                                         &winSize, &dispUnit, &nbOutbox);
+                    receivedTot = (int) nbOutbox[2*t];
+                    nbOutbox   += (int) nbOutbox[2*t+1];
+                }
     
-                for (int ptclNum = 0; ptclNum < receivedTot; ptclNum++){
+                for (ptclNum = 0; ptclNum < receivedTot; ptclNum++){
                     particles2add.push_back(shared_ptr<Particle>(new Particle));
                     int idxOfAdded = particles2add.size()-1;
-                    particles2add[idxOfAdded]->deserialize(recvBuf[t], PARTICLES_SIZE*ptclNum);
+                    particles2add[idxOfAdded]->deserialize(nbOutbox, PARTICLES_SIZE*ptclNum);
                 }
                 
             }
     }
     
-    for ( t = 0; t < 27; t++ ) {
-                delete [] sendBuf[t];
-                delete [] recvBuf[t];
+    //# neighbours have finished reading the outbox
+    if( loader->useSharedMemory ){
+        MPI_Win_fence(0, outboxWin);
     }
+}
+
+
+//  outbox: {count, offset} for every direction, then particles;
+//  the window is reallocated on the node when some outbox is too small
+void BoundaryManager::fillOutbox(double* sendBuf[27], int partcls2send[27]){
     
-    auto end_time = high_resolution_clock::now();
-    string msg ="[BoundaryManager] apply BC duration = "
-    +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
-    logger->writeMsg(msg.c_str(),  DEBUG);
+    int t, need = 2*27, maxNeed;
+    
+    for( t = 0; t < 27; t++ ){
+        if( loader->nodeNeighbors2Send[t] != MPI_PROC_NULL ){
+            need += PARTICLES_SIZE*partcls2send[t];
+        }
+    }
+    
+    MPI_Allreduce(&need, &maxNeed, 1, MPI_INT, MPI_MAX, loader->nodeComm);
+    
+    if( maxNeed > outboxCapacity ){
+        if( outboxWin != MPI_WIN_NULL ){
+            MPI_Win_free(&outboxWin);
+        }
+        outboxCapacity = 2*maxNeed;
+        MPI_Win_allocate_shared(sizeof(double)*outboxCapacity, sizeof(double),
+                                MPI_INFO_NULL, loader->nodeComm, &outbox, &outboxWin);
+        
+        string msg ="[BoundaryManager] shared outbox capacity = "
+                    +to_string(outboxCapacity)+" doubles";
+        logger->writeMsg(msg.c_str(), DEBUG);
+    }
+    
+    int offset = 2*27;
+    for( t = 0; t < 27; t++ ){
+        outbox[2*t]   = 0;
+        outbox[2*t+1] = offset;
+        if( loader->nodeNeighbors2Send[t] != MPI_PROC_NULL ){
+            outbox[2*t] = partcls2send[t];
+            copy(sendBuf[t], sendBuf[t]+PARTICLES_SIZE*partcls2send[t], outbox+offset);
+            offset += PARTICLES_SIZE*partcls2send[t];
+        }
+    }
+    
+    //# outbox is ready to be read by the neighbours
+    MPI_Win_fence(0, outboxWin);
 }
 
 
@@ -494,6 +597,7 @@ void BoundaryManager::reset(){
     }
 }
 
+template<int DIM>
 void BoundaryManager::storeParticle(int idx, double pos[3]){
     double domainShiftX = loader->boxCoordinates[0][0];
     double domainShiftY = loader->boxCoordinates[1][0];
@@ -513,26 +617,9 @@ void BoundaryManager::storeParticle(int idx, double pos[3]){
     z = (pos[2] - domainShiftZ)/domainZSize/dz;
     
   
-    switch (loader->dim) {
-        case 1:
-            a = (int)floor(x);
-            b = 0;
-            c = 0;
-            break;
-        case 2:
-            a = (int)floor(x);
-            b = (int)floor(y);
-            c = 0;
-            break;
-        case 3:
-            a = (int)floor(x);
-            b = (int)floor(y);
-            c = (int)floor(z);
-            break;
-            
-        default:
-            throw runtime_error("dimension is not 1/2/3");
-    }
+    a = (int)floor(x);
+    b = DIM > 1 ? (int)floor(y) : 0;
+    c = DIM > 2 ? (int)floor(z) : 0;
 
     
     domain = (1+c)+3*((1+b)+3*(1+a));
@@ -564,13 +651,9 @@ void BoundaryManager::storeParticle(int idx, double pos[3]){
 }
 
 
-
-
-
-
-
-
-
-
-
-
+template int  BoundaryManager::isPtclOutOfDomain<1>(double[3]);
+template int  BoundaryManager::isPtclOutOfDomain<2>(double[3]);
+template int  BoundaryManager::isPtclOutOfDomain<3>(double[3]);
+template void BoundaryManager::storeParticle<1>(int, double[3]);
+template void BoundaryManager::storeParticle<2>(int, double[3]);
+template void BoundaryManager::storeParticle<3>(int, double[3]);
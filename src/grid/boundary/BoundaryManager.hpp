@@ -6,6 +6,7 @@
 #include <cmath>
 #include <memory>
 #include <chrono>
+#include <algorithm>
 
 
 #include <mpi.h>
@@ -33,21 +34,36 @@ private:
     
     std::unique_ptr<Logger> logger;
     std::shared_ptr<Loader> loader;
+    std::shared_ptr<GridManager> gridMgr;
+    std::shared_ptr<Workspace> workspace;
     
     std::vector<int> leavingParticles;
     std::map<int, int> domain2send;
+    double* recvBufs[27];
+    
+    //# outbox in a shared window for neighbours on the same node
+    MPI_Win outboxWin = MPI_WIN_NULL;
+    double* outbox;
+    int outboxCapacity = 0;
     
     void initialize();
+    void exchangeParticles(double*[27], double*[27], int[27], int[27],
+                           std::vector<std::shared_ptr<Particle>> &);
+    void fillOutbox(double*[27], int[27]);
     int applyPeriodicBC(Particle*, int);
     int applyOutflowBC(int);
     
 public:
     
-    BoundaryManager(std::shared_ptr<Loader>);
+    BoundaryManager(std::shared_ptr<Loader>, std::shared_ptr<GridManager>,
+                    std::shared_ptr<Workspace>);
+    ~BoundaryManager();
     
+    template<int DIM>
     int isPtclOutOfDomain(double[3]);
     void reset();
     std::vector<int> getLeavingParticlesIdxs();
+    template<int DIM>
     void storeParticle(int, double[3]);
     void applyBC(Particle**, std::vector<std::shared_ptr<Particle>> &, int);
     void applyBC(Particle**, std::vector<std::shared_ptr<Particle>> &, std::vector<std::shared_ptr<Particle>> &, int);
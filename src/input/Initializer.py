@@ -24,9 +24,24 @@ class Initializer:
          
         self.mpiCores  = [1,2,1]
         
+        self.haloExchangeType = 0 #0 - 26 neighbours, 1 - three-stage x,y,z faces
+        self.useSharedMemory  = 0 #1 - on-node neighbours read halos from shared memory
+        
+        self.smoothIterations = 1 #passes of the 27-point filter per smoothing
+        self.smoothGhostWidth = 1 #ghost layers of smoothing, width-1 passes per exchange
+        self.tileSize = [16, 16, 0] #nodes per tile of grid kernels along x,y,z, 0 - whole extent
+        self.particleOrdering = 0 #particles sorted by 0 - cells x,y,z, 1 - tiles, 2 - Morton curve
+        self.gridThreads = 1 #threads of grid kernels per rank, needs a build with OpenMP
+        
         # time
         self.ts = 0.01
         self.maxtsnum = 501
+        self.maxFieldSubcycles = 1 #max sub-steps of B per timestep, set by whistler speed
+        self.adaptiveTs = 0 #1 - timestep set by CFL, whistler and gyration between minTs and maxTs
+        self.minTs = 0.0005
+        self.maxTs = 0.04
+        self.courantNumber = 0.5 #fraction of the CFL, whistler and gyration limits to use
+        self.maxClampedFraction = 0.001 #step retried with half timestep if E clamped at more nodes
         self.outputStride = 50
 
         # output. need to create it before
@@ -120,6 +135,16 @@ class Initializer:
     
     def getZmpiDomainNum(self):
         return self.mpiCores[2]
+
+    #   halo exchange: 0 - 26 neighbours (default)
+    #                  1 - x, y, z faces in three stages (6 messages)
+    def getHaloExchangeType(self):
+        return self.haloExchangeType
+    
+    #   1 - neighbours on the same node exchange halos and particles
+    #       through MPI-3 shared memory windows, messages otherwise
+    def getUseSharedMemory(self):
+        return self.useSharedMemory
     
     
     #   BC
@@ -167,6 +192,29 @@ class Initializer:
     def getMaxTimestepsNum(self):
         return self.maxtsnum
     
+    #   magnetic field is advanced in up to that many sub-steps per
+    #   timestep with frozen ion moments when whistlers need a shorter step
+    def getMaxFieldSubcycles(self):
+        return self.maxFieldSubcycles
+    
+    #   timestep follows the stiffness of the solution within [minTs, maxTs],
+    #   a step is rolled back and retried with half timestep if the E field
+    #   breakdown clamp fires at more than maxClampedFraction of the nodes
+    def getAdaptiveTimestep(self):
+        return self.adaptiveTs
+    
+    def getMinTimestep(self):
+        return self.minTs
+    
+    def getMaxTimestep(self):
+        return self.maxTs
+    
+    def getCourantNumber(self):
+        return self.courantNumber
+    
+    def getMaxClampedFraction(self):
+        return self.maxClampedFraction
+    
     #   output
     def getOutputDir(self):
         return self.outputDir
@@ -403,6 +451,36 @@ class Initializer:
     def getElectronPressureSmoothingStride(self):
         return self.smoothStride
 
+    #   smoothing of fields: number of passes of the 27-point filter
+    def getSmoothingIterations(self):
+        return self.smoothIterations
+    
+    #   ghost layers of the smoothing workspace: passes between two
+    #   exchanges are done redundantly on them, width-1 passes per exchange;
+    #   with shared memory smoothing exchanges after every pass
+    def getSmoothingGhostWidth(self):
+        return self.smoothGhostWidth
+
+    #   grid kernels sweep the domain by tiles of nodes
+    def getXtileSize(self):
+        return self.tileSize[0]
+    
+    def getYtileSize(self):
+        return self.tileSize[1]
+    
+    def getZtileSize(self):
+        return self.tileSize[2]
+    
+    #   order of cells for sorting of particles: 0 - x, y, z
+    #                                            1 - tiles of grid kernels
+    #                                            2 - Morton (Z-order) curve
+    def getParticleOrdering(self):
+        return self.particleOrdering
+
+    #   grid kernels share tiles and slabs among threads of the rank
+    def getGridThreadsNum(self):
+        return self.gridThreads
+
     #   physics: pressure evolution : 1 - isothermal (optional), 0 - evolution equation
     def getIfWeUseIsothermalClosure(self):
         return 0
@@ -14,6 +14,12 @@ const string  BRACKETS_3DOUBLE = "(ddd)";
 const string  GET = "get";
 const string  GET_TIMESTEP = "getTimestep";
 const string  GET_MAX_TIMESTEPS_NUM = "getMaxTimestepsNum";
+const string  GET_MAX_FIELD_SUBCYCLES = "getMaxFieldSubcycles";
+const string  GET_ADAPTIVE_TIMESTEP = "getAdaptiveTimestep";
+const string  GET_MIN_TIMESTEP = "getMinTimestep";
+const string  GET_MAX_TIMESTEP = "getMaxTimestep";
+const string  GET_COURANT_NUMBER = "getCourantNumber";
+const string  GET_MAX_CLAMPED_FRACTION = "getMaxClampedFraction";
 const string  GET_NUM_OF_SPECIES = "getNumOfSpecies";
 const string  GET_TIMESTEP_WRITE = "getOutputTimestep";
 const string  GET_OUTPUT_DIR = "getOutputDir";
@@ -24,6 +30,11 @@ const string  GET_ELEPRESXX  = "getElectronPressureXX";
 const string  GET_ELEPRESYY  = "getElectronPressureYY";
 const string  GET_ELEPRESZZ  = "getElectronPressureZZ";
 const string  GET_PRESSURE_SMOOTH_STRIDE = "getElectronPressureSmoothingStride";
+const string  GET_SMOOTH_ITERATIONS = "getSmoothingIterations";
+const string  GET_GHOST_WIDTH = "getSmoothingGhostWidth";
+const string  GET_TILE_SIZE = "tileSize";
+const string  GET_PARTICLE_ORDERING = "getParticleOrdering";
+const string  GET_GRID_THREADS = "getGridThreadsNum";
 const string  GET_VELOCITY = "getVelocity";
 const string  GET_FLUID_VELOCITY = "getFluidVelocity";
 const string  INJECTED_PARTICLES = "4InjectedParticles";
@@ -75,6 +86,9 @@ const string  GET_LASER_PULSE_DURATION = "getLaserPulseDuration";
 const string  GET_TARGET_ION_DENSITY2SUSTAIN = "getTargetIonDensity2sustain";
 const string  GET_ELECTRON_PRESSURE2SUSTAIN  = "getElectronPressure2sustain";
 
+const string  GET_HALO_EXCHANGE_TYPE = "getHaloExchangeType";
+const string  GET_USE_SHARED_MEMORY  = "getUseSharedMemory";
+
 const string  dirs[] = {"X", "Y", "Z"};
 
 
@@ -291,6 +305,54 @@ void Loader::initMPIcoordinatesOfDomains( int rank, int cs[3] ){
             }
         }
     }
+    
+    //  messages from and to MPI_PROC_NULL only cost a call:
+    //  exchanges go through the directions which have a rank
+    for( int t = 0; t < 27; t++ ){
+        if( t != 13 && ( neighbors2Send[t] != MPI_PROC_NULL
+                      || neighbors2Recv[t] != MPI_PROC_NULL ) ){
+            this->haloNeighbors.push_back(t);
+        }
+    }
+    
+    string msg = "[Loader] [MPI] rank = "+to_string(rank)
+                +" exchanges with "+to_string(haloNeighbors.size())+" neighbours";
+    logger.writeMsg(msg.c_str(), DEBUG);
+}
+
+
+//  neighbours on the same node get their rank in nodeComm,
+//  the others (and all of them if shared memory is off) MPI_PROC_NULL
+void Loader::initNodeNeighbors(){
+    
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, 0, MPI_INFO_NULL, &nodeComm);
+    
+    MPI_Group worldGroup, nodeGroup;
+    MPI_Comm_group(MPI_COMM_WORLD, &worldGroup);
+    MPI_Comm_group(nodeComm, &nodeGroup);
+    
+    int nodeRank;
+    
+    for( int t = 0; t < 27; t++ ){
+        this->nodeNeighbors2Send.push_back(MPI_PROC_NULL);
+        this->nodeNeighbors2Recv.push_back(MPI_PROC_NULL);
+        
+        if( !useSharedMemory || t == 13 ){
+            continue;
+        }
+        
+        if( neighbors2Send[t] != MPI_PROC_NULL ){
+            MPI_Group_translate_ranks(worldGroup, 1, &neighbors2Send[t], nodeGroup, &nodeRank);
+            this->nodeNeighbors2Send[t] = nodeRank == MPI_UNDEFINED ? MPI_PROC_NULL : nodeRank;
+        }
+        if( neighbors2Recv[t] != MPI_PROC_NULL ){
+            MPI_Group_translate_ranks(worldGroup, 1, &neighbors2Recv[t], nodeGroup, &nodeRank);
+            this->nodeNeighbors2Recv[t] = nodeRank == MPI_UNDEFINED ? MPI_PROC_NULL : nodeRank;
+        }
+    }
+    
+    MPI_Group_free(&worldGroup);
+    MPI_Group_free(&nodeGroup);
 }
 
 
@@ -408,6 +470,15 @@ void Loader::load(){
     
         int cs[3];
         initMPIcoordinatesOfDomains( rank, cs );
+    
+        this->haloExchangeType = (int) callPyLongFunction( pInstance, GET_HALO_EXCHANGE_TYPE, BRACKETS );
+    
+        if( haloExchangeType != ALL_NEIGHBORS_EXCHANGE && haloExchangeType != FACE_STAGED_EXCHANGE ){
+            throw runtime_error("unknown halo exchange type!");
+        }
+    
+        this->useSharedMemory = (int) callPyLongFunction( pInstance, GET_USE_SHARED_MEMORY, BRACKETS );
+        initNodeNeighbors();
 
         double boxSizePerDomain[3];
     
@@ -483,6 +554,32 @@ void Loader::load(){
     
     this->timeStep              =  callPyFloatFunction( pInstance, GET_TIMESTEP, BRACKETS );
     
+    this->maxFieldSubcycles = (int) callPyLongFunction( pInstance, GET_MAX_FIELD_SUBCYCLES, BRACKETS);
+    if( maxFieldSubcycles < 1 ){
+        maxFieldSubcycles = 1;
+    }
+    
+    this->adaptiveTimeStep = (int) callPyLongFunction( pInstance, GET_ADAPTIVE_TIMESTEP, BRACKETS);
+    if( adaptiveTimeStep ){
+        this->minTimeStep = callPyFloatFunction( pInstance, GET_MIN_TIMESTEP, BRACKETS );
+        this->maxTimeStep = callPyFloatFunction( pInstance, GET_MAX_TIMESTEP, BRACKETS );
+        this->courantNumber = callPyFloatFunction( pInstance, GET_COURANT_NUMBER, BRACKETS );
+        this->maxClampedFraction = callPyFloatFunction( pInstance, GET_MAX_CLAMPED_FRACTION, BRACKETS );
+        if( minTimeStep <= 0.0 ){
+            minTimeStep = timeStep/32;
+        }
+        if( maxTimeStep <= 0.0 ){
+            maxTimeStep = 4*timeStep;
+        }
+        if( courantNumber <= 0.0 ){
+            courantNumber = 0.5;
+        }
+        if( maxClampedFraction <= 0.0 ){
+            maxClampedFraction = 0.001;
+        }
+        timeStep = min(max(timeStep, minTimeStep), maxTimeStep);
+    }
+    
     this->numOfSpecies          =  callPyFloatFunction( pInstance, GET_NUM_OF_SPECIES, BRACKETS );
     
     this->minimumDens2ResolvePPC = callPyFloatFunction( pInstance, GET_MIN_DENS_4_PPC, BRACKETS );
@@ -501,6 +598,32 @@ void Loader::load(){
     
     this->smoothStride     = (int) callPyLongFunction( pInstance, GET_PRESSURE_SMOOTH_STRIDE, BRACKETS);
     
+    this->smoothIterations = (int) callPyLongFunction( pInstance, GET_SMOOTH_ITERATIONS, BRACKETS);
+    if( smoothIterations < 1 ){
+        smoothIterations = 1;
+    }
+    
+    this->ghostWidth = (int) callPyLongFunction( pInstance, GET_GHOST_WIDTH, BRACKETS);
+    if( ghostWidth < 1 ){
+        ghostWidth = 1;
+    }
+    
+    for( int n = 0; n < 3; n++ ){
+        string tile = GET + dirs[n] + GET_TILE_SIZE;
+        this->tileSize[n] = (int) callPyLongFunction( pInstance, tile, BRACKETS );
+    }
+    
+    this->particleOrdering = (int) callPyLongFunction( pInstance, GET_PARTICLE_ORDERING, BRACKETS);
+    if( particleOrdering != CELL_ORDERING && particleOrdering != TILE_ORDERING
+       && particleOrdering != MORTON_ORDERING ){
+        throw runtime_error("unknown particle ordering!");
+    }
+    
+    this->gridThreads = (int) callPyLongFunction( pInstance, GET_GRID_THREADS, BRACKETS);
+    if( gridThreads < 1 ){
+        gridThreads = 1;
+    }
+    
     this->relaxFactor            = callPyFloatFunction( pInstance, GET_RELAX_FACTOR, BRACKETS );
 
     this->useIsothermalClosure = (int) callPyLongFunction( pInstance, IF2USE_ISOTHERMAL_CLOSURE, BRACKETS);
@@ -523,6 +646,8 @@ void Loader::load(){
         }
                 
         this->laserPulseDuration_tsnum = (int) callPyLongFunction( pInstance, GET_LASER_PULSE_DURATION, BRACKETS);
+        //# pulse ends in simulation time, the timestep may change during the run
+        this->laserPulseDuration = laserPulseDuration_tsnum*timeStep;
     }
     
     auto callMethod = getPyMethod( pInstance, GET_CELL_BREAKDOWN_EFIELD_FACTOR, BRACKETS );
@@ -599,6 +724,15 @@ void Loader::load(){
         
         msg = "[Loader] [COMMON] timeStep = "+to_string(timeStep);
         logger.writeMsg(msg.c_str(), INFO);
+        msg = "[Loader] [COMMON] max sub-steps of magnetic field per timeStep = "
+              +to_string(maxFieldSubcycles)+" (1 - no subcycling)";
+        logger.writeMsg(msg.c_str(), INFO);
+        if( adaptiveTimeStep ){
+            msg = "[Loader] [COMMON] adaptive timeStep in ["+to_string(minTimeStep)
+                  +", "+to_string(maxTimeStep)+"], courant number = "+to_string(courantNumber)
+                  +", max fraction of nodes with clamped E = "+to_string(maxClampedFraction);
+            logger.writeMsg(msg.c_str(), INFO);
+        }
         
         msg = "[Loader] [COMMON] Max timeStep number = "+to_string(maxTimestepsNum);
         logger.writeMsg(msg.c_str(), INFO);
@@ -612,13 +746,35 @@ void Loader::load(){
         logger.writeMsg(msg.c_str(), INFO);
         msg = "[Loader] [COMMON] minimum density resolved by ppc number = "+to_string(minimumDens2ResolvePPC);
         logger.writeMsg(msg.c_str(), INFO);
+        msg = "[Loader] [COMMON] smoothing iterations = "+to_string(smoothIterations);
+        logger.writeMsg(msg.c_str(), INFO);
+        msg = "[Loader] [COMMON] ghost layers of smoothing = "+to_string(ghostWidth)
+              +" ("+to_string(max(ghostWidth-1, 1))+" passes per exchange)";
+        logger.writeMsg(msg.c_str(), INFO);
+        msg = "[Loader] [COMMON] tile size of grid kernels = "+to_string(tileSize[0])
+              +" x "+to_string(tileSize[1])+" x "+to_string(tileSize[2])+" (0 - whole extent)";
+        logger.writeMsg(msg.c_str(), INFO);
+        msg = "[Loader] [COMMON] threads of grid kernels per rank = "+to_string(gridThreads);
+        logger.writeMsg(msg.c_str(), INFO);
+        msg = particleOrdering == MORTON_ORDERING ? "Morton curve of cells"
+            : particleOrdering == TILE_ORDERING   ? "cells by tiles of grid kernels"
+                                                  : "cells x, y, z (default)";
+        msg = "[Loader] [COMMON] particles are sorted by "+msg;
+        logger.writeMsg(msg.c_str(), INFO);
+        msg = haloExchangeType == FACE_STAGED_EXCHANGE ? "three-stage x/y/z faces (6 messages)"
+                                                       : "26 neighbours (default)";
+        msg = "[Loader] [MPI] halo exchange: "+msg;
+        logger.writeMsg(msg.c_str(), INFO);
+        msg = "[Loader] [MPI] shared memory for on-node neighbours: "
+              +string(useSharedMemory ? "on" : "off");
+        logger.writeMsg(msg.c_str(), INFO);
         
         if( numOfSpots > 0 ){
             msg = "[Loader] [LASER] numOfSpots = "+to_string(numOfSpots)
                     +"; prtclType2Load = "+to_string(prtclType2Load+1);
             logger.writeMsg(msg.c_str(), INFO);
             msg = "[Loader] [LASER] laserPulseDuration_tsnum = "+to_string(laserPulseDuration_tsnum)
-            +"; laserPulseDuration_omega = "+to_string(laserPulseDuration_tsnum*timeStep);
+            +"; laserPulseDuration_omega = "+to_string(laserPulseDuration);
             logger.writeMsg(msg.c_str(), INFO);
         
         }
@@ -674,6 +830,10 @@ double Loader::getTimeStep(){
     return timeStep;
 }
 
+void Loader::setTimeStep(double ts){
+    timeStep = ts;
+}
+
 int Loader::getMaxTimestepsNum(){
     return maxTimestepsNum;
 }
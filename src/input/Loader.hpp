@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include <set>
+#include <algorithm>
 #include <math.h>
 #include "../misc/Logger.hpp"
 #include "../misc/Misc.hpp"
@@ -31,6 +32,17 @@ enum ParticleBCtype{
     REFLECT_BC
 };
 
+enum HaloExchangeType{
+    ALL_NEIGHBORS_EXCHANGE,
+    FACE_STAGED_EXCHANGE
+};
+
+enum ParticleOrdering{
+    CELL_ORDERING,
+    TILE_ORDERING,
+    MORTON_ORDERING
+};
+
 #define METHOD_OK   0
 #define METHOD_FAIL 1
 
@@ -62,6 +74,7 @@ private:
     PyObject * getPyMethod( PyObject*, const std::string, const std::string );
     
     void initMPIcoordinatesOfDomains( int, int[3] );
+    void initNodeNeighbors();
     int checkMethodExistence(const std::string, const std::string);
 
 
@@ -92,6 +105,20 @@ public:
     double electronTemperature = 0.0;
     
     int smoothStride;
+    int smoothIterations = 1;
+    int ghostWidth = 1;
+    int tileSize[3] = {0, 0, 0};
+    int particleOrdering = CELL_ORDERING;
+    int gridThreads = 1;
+    int maxFieldSubcycles = 1;
+    
+    //adaptive timestep: set between steps by the CFL, whistler and
+    //gyration limits, a step clamping E too often is retried with less
+    int adaptiveTimeStep = 0;
+    double minTimeStep = 0.0;
+    double maxTimeStep = 0.0;
+    double courantNumber = 0.5;
+    double maxClampedFraction = 0.001;
     double electronmass;
     double relaxFactor;
     
@@ -103,11 +130,22 @@ public:
     int numOfSpots = 0;
     int prtclType2Load;
     int laserPulseDuration_tsnum;
+    double laserPulseDuration;
     double loadedEnergyPerStep = 0.0;
     
     //MPI staff
     std::vector<int> neighbors2Send;//27
     std::vector<int> neighbors2Recv;//27
+    //directions t != 13 with a rank to send to or to receive from,
+    //e.g. 8 in a 2D run with damping BC along z
+    std::vector<int> haloNeighbors;
+    int haloExchangeType = ALL_NEIGHBORS_EXCHANGE;
+    
+    //MPI-3 shared memory: neighbours on the same node
+    int useSharedMemory = 0;
+    MPI_Comm nodeComm;
+    std::vector<int> nodeNeighbors2Send;//27, rank in nodeComm or MPI_PROC_NULL
+    std::vector<int> nodeNeighbors2Recv;//27
     
     
     Loader();
@@ -128,6 +166,7 @@ public:
     std::vector<double> getFluidVelocity4InjectedParticles(double,double,double);
     std::vector<double> getVelocity4InjectedParticles(double,double,double);
     double getTimeStep();
+    void setTimeStep(double);
     int getMaxTimestepsNum();
     int getNumberOfSpecies();
     int getTimestepsNum2Write();
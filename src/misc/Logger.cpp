@@ -6,32 +6,31 @@ using namespace std;
 
 
 Logger::Logger(){
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
 }
 
 Logger::~Logger(){
 }
 
+//  a message is written in one piece, lines of concurrent tasks do not mix
 void Logger::writeMsg(const char* input, int level){
-    int rank ;
     
     set<int> allowedRanks = {0};
     
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    string line = "["+to_string(rank)+"] ["+to_string(level)+"] "+input+".\n";
     
     if (level <= MINIMAL_LEVEL && allowedRanks.count(rank)){
-        cout << "[" << rank << "] " << "[" << level << "] " << input <<  "." << endl;
+        cout << line << flush;
     }
     
     if (level == CRITICAL){
-        cout << "[" << rank << "] " << "[" << level << "] " << input <<  "." << endl;
+        cout << line << flush;
     }
 }
 
 void Logger::writeMsg(const char* input){
-    int rank ;
-    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     if (rank == 0){
-        cout << "[INFO] " << input <<  "." << endl;
+        cout << string("[INFO] ")+input+".\n" << flush;
     }
 }
 
@@ -19,8 +19,13 @@
     #define MINIMAL_LEVEL 1
 #endif
 
+//  the rank is taken when the logger is created, so the workers of a
+//  task graph can log without calling MPI
 class Logger
 {
+private:
+    int rank;
+    
 public:
     Logger();
     void writeMsg(const char* input);
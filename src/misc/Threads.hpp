@@ -0,0 +1,62 @@
+#ifndef Threads_hpp
+#define Threads_hpp
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+//  OpenMP directive without the leading "omp", e.g. OMP(parallel for),
+//  expands to nothing in a build without OpenMP
+#ifdef _OPENMP
+#define OMP_DIRECTIVE(...) _Pragma(#__VA_ARGS__)
+#define OMP(...) OMP_DIRECTIVE(omp __VA_ARGS__)
+#else
+#define OMP(...)
+#endif
+
+//  grid kernels share their tiles, slabs or node ranges among the threads
+//  of the rank when built with OpenMP (-fopenmp), every node is computed
+//  by one thread as in the serial sweep, so the results do not depend on
+//  the number of threads. Without OpenMP everything runs on one thread
+
+inline void setThreadsNum(int threadsNum){
+#ifdef _OPENMP
+    omp_set_num_threads(threadsNum);
+#endif
+}
+
+//  threads a parallel region is started with
+inline int getThreadsNum(){
+#ifdef _OPENMP
+    return omp_get_max_threads();
+#else
+    return 1;
+#endif
+}
+
+//  thread inside a parallel region and the size of its team
+inline int getThreadNum(){
+#ifdef _OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
+inline int getTeamSize(){
+#ifdef _OPENMP
+    return omp_get_num_threads();
+#else
+    return 1;
+#endif
+}
+
+//  contiguous part [from, to) of num items taken by the calling thread,
+//  parts follow the thread order as with the static schedule
+inline void getThreadShare(long num, long& from, long& to){
+    int thread = getThreadNum(), teamSize = getTeamSize();
+    from = num*thread/teamSize;
+    to   = num*(thread+1)/teamSize;
+}
+
+#endif /* Threads_hpp */
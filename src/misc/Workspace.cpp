@@ -0,0 +1,81 @@
+#include "Workspace.hpp"
+
+using namespace std;
+
+
+Workspace::Workspace(){
+    logger.reset(new Logger());
+    logger->writeMsg("[Workspace] create...OK", DEBUG);
+}
+
+
+Workspace::~Workspace(){
+    for( int n = 0; n < overflow.size(); n++ ){
+        free(overflow[n].second);
+    }
+    free(buffer);
+}
+
+
+char* Workspace::allocBytes(long bytes){
+    void* ptr = nullptr;
+    if( posix_memalign(&ptr, WORKSPACE_ALIGNMENT, max(bytes, 1L)) != 0 ){
+        throw runtime_error("workspace allocation failed!");
+    }
+    return (char*) ptr;
+}
+
+
+void* Workspace::borrowBytes(long bytes){
+
+    bytes = (bytes+WORKSPACE_ALIGNMENT-1)/WORKSPACE_ALIGNMENT*WORKSPACE_ALIGNMENT;
+
+    char* ptr;
+    if( top+bytes <= capacity ){
+        ptr = buffer+top;
+    }else{
+        ptr = allocBytes(bytes);
+        overflow.push_back(make_pair(top, ptr));
+        heapAllocations++;
+    }
+
+    top += bytes;
+    highWater = max(highWater, top);
+    return ptr;
+}
+
+
+long Workspace::getMark(){
+    return top;
+}
+
+
+//  gives back everything borrowed after the mark
+void Workspace::release(long mark){
+
+    while( !overflow.empty() && overflow.back().first >= mark ){
+        free(overflow.back().second);
+        overflow.pop_back();
+    }
+    top = mark;
+
+    if( top == 0 && highWater > capacity ){
+        free(buffer);
+        buffer = allocBytes(highWater);
+        capacity = highWater;
+        heapAllocations++;
+
+        string msg = "[Workspace] regrown to "+to_string(capacity/1024)+" kB";
+        logger->writeMsg(msg.c_str(), DEBUG);
+    }
+}
+
+
+long Workspace::getHighWaterMark(){
+    return highWater;
+}
+
+
+long Workspace::getHeapAllocationsNum(){
+    return heapAllocations;
+}
@@ -0,0 +1,76 @@
+#ifndef Workspace_hpp
+#define Workspace_hpp
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include "Logger.hpp"
+
+//  alignment (bytes) of the buffers borrowed from the workspace
+#define WORKSPACE_ALIGNMENT 64
+
+//  scratch memory of the timestep shared by all managers: buffers are
+//  borrowed in stack order and given back by the scope that borrowed them.
+//  A buffer that does not fit is taken from the heap and the workspace is
+//  regrown to the high-water mark once everything is given back, so after
+//  the first step no memory is allocated
+class Workspace{
+
+private:
+    std::unique_ptr<Logger> logger;
+
+    char* buffer = nullptr;
+    long capacity = 0;
+    long top = 0;
+    long highWater = 0;
+    long heapAllocations = 0;
+
+    //# buffers beyond the capacity: offset in the workspace, memory
+    std::vector<std::pair<long, char*>> overflow;
+
+    static char* allocBytes(long);
+    void* borrowBytes(long);
+
+public:
+    Workspace();
+    ~Workspace();
+
+    template<typename T>
+    T* borrow(long num){
+        return (T*) borrowBytes(sizeof(T)*num);
+    }
+
+    long getMark();
+    void release(long);
+
+    long getHighWaterMark();
+    long getHeapAllocationsNum();
+};
+
+
+//  buffers borrowed from the workspace during the lifetime of the scope
+class WorkspaceScope{
+
+private:
+    Workspace& workspace;
+    long mark;
+
+public:
+    WorkspaceScope(Workspace& workspace):workspace(workspace), mark(workspace.getMark()){}
+    ~WorkspaceScope(){
+        workspace.release(mark);
+    }
+
+    template<typename T>
+    T* borrow(long num){
+        return workspace.borrow<T>(num);
+    }
+};
+
+#endif /* Workspace_hpp */
@@ -435,12 +435,12 @@ void Writer::writeAllForRestart(){
     
     int totVarsOnG2 = gridMgr->getVarsNumOnG2();
     for ( int varN=0; varN<totVarsOnG2; varN++){
-        VectorVar** vars = gridMgr->getVectorVariableOnG2(varN);
-        int varSize = vars[0]->getSize();
+        FieldG2 vars = gridMgr->getFieldOnG2(varN);
+        int varSize = vars.getSize();
         for ( int dir=0; dir<varSize; dir++){
             double* field = new double[totalNodeNumG2];
             for (idx = 0; idx < totalNodeNumG2; idx++) {
-                field[idx] = vars[idx]->getValue()[dir];
+                field[idx] = vars(idx, dir);
             }
             string varName = "g2_"+to_string(varN)+"_"+to_string(dir);
             
@@ -455,12 +455,12 @@ void Writer::writeAllForRestart(){
     
     int totVarsOnG1 = gridMgr->getVarsNumOnG1();
     for ( int varN=0; varN<totVarsOnG1; varN++){
-        VectorVar** vars = gridMgr->getVectorVariableOnG1(varN);
-        int varSize = vars[0]->getSize();
+        FieldG1 vars = gridMgr->getFieldOnG1(varN);
+        int varSize = vars.getSize();
         for ( int dir=0; dir<varSize; dir++){
             double* field = new double[totalNodeNumG1];
             for (idx = 0; idx < totalNodeNumG1; idx++) {
-                field[idx] = vars[idx]->getValue()[dir];
+                field[idx] = vars(idx, dir);
             }
             string varName = "g1_"+to_string(varN)+"_"+to_string(dir);
             writeParallelWithOffset(fileID, group, dxpl_id, varName, field,
@@ -5,10 +5,12 @@ using namespace chrono;
 
 IonIonCollisionManager::IonIonCollisionManager(shared_ptr<Loader> ldr,
                                                shared_ptr<GridManager> gridMnr,
-                                               shared_ptr<Pusher> pshr):
+                                               shared_ptr<Pusher> pshr,
+                                               shared_ptr<Workspace> wrkspc):
                                                loader(move(ldr)), 
                                                gridMgr(move(gridMnr)),
-                                               pusher(move(pshr))
+                                               pusher(move(pshr)),
+                                               workspace(move(wrkspc))
 {
 
 
@@ -49,7 +51,8 @@ void IonIonCollisionManager::collideIons(int phase){
     
     int G2nodesNumber = xSizeG2*ySizeG2*zSizeG2;
 
-    int* particlesNumber = new int[G2nodesNumber*numOfSpecies];
+    WorkspaceScope scope(*workspace);
+    int* particlesNumber = scope.borrow<int>(G2nodesNumber*numOfSpecies);
     map<int, map<int, vector<int>>> particlesInEachCell;
 
     for( idx = 0; idx < G2nodesNumber; idx++ ){
@@ -65,9 +68,9 @@ void IonIonCollisionManager::collideIons(int phase){
     double* pos;
     double* vel;
     double pw, mass;
-    map<int, VectorVar**> dens_vel;
+    map<int, FieldG2> dens_vel;
     for( type = 0; type < numOfSpecies; type++ ){
-            dens_vel[type] = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(type));
+            dens_vel[type] = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(type));
     }
 
     double domainShiftX = loader->boxCoordinates[0][0];
@@ -114,7 +117,7 @@ void IonIonCollisionManager::collideIons(int phase){
         for( type = 0; type < numOfSpecies; type++ ){
             if( pusher->getIfParticleTypeIsFrozen(type) == 1 ) continue;
 
-            dens1 = dens_vel[type][idxG2]->getValue()[0];
+            dens1 = dens_vel[type](idxG2, 0);
 
             int numOfPartclsOfGvnType = particlesNumber[numOfSpecies*idxG2+type];
             if( numOfPartclsOfGvnType == 0 ) continue;
@@ -169,7 +172,7 @@ void IonIonCollisionManager::collideIons(int phase){
                 if( numOfPartclsOfGvnType2 == 0 ) continue;
 
                 pw2 = pusher->getParticleWeight4Type(type2);
-                dens2 = dens_vel[type2][idxG2]->getValue()[0];
+                dens2 = dens_vel[type2](idxG2, 0);
                 
                 if( numOfPartclsOfGvnType >= numOfPartclsOfGvnType2 ){
 
@@ -235,8 +238,6 @@ void IonIonCollisionManager::collideIons(int phase){
     }
 
 
-    delete [] particlesNumber;
-
     auto end_time = high_resolution_clock::now();
     auto msg ="[IonIonCollisionManager] collideIons()... duration = "
                 +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
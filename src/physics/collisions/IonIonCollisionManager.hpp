@@ -23,6 +23,7 @@ private:
     std::shared_ptr<Loader> loader;
     std::shared_ptr<GridManager> gridMgr;
     std::shared_ptr<Pusher> pusher;
+    std::shared_ptr<Workspace> workspace;
     
     
     void initialize();
@@ -30,7 +31,8 @@ private:
 public:
     IonIonCollisionManager(std::shared_ptr<Loader>,
                            std::shared_ptr<GridManager>,
-                           std::shared_ptr<Pusher>);
+                           std::shared_ptr<Pusher>,
+                           std::shared_ptr<Workspace>);
     ~IonIonCollisionManager();
     void collideIons(int);
 
@@ -15,12 +15,7 @@ EleMagManager::EleMagManager(std::shared_ptr<Loader> ldr,
 
 void EleMagManager::initialize(){
     
-    int xRes = loader->resolution[0],
-        yRes = loader->resolution[1],
-        zRes = loader->resolution[2];
-    int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    
-    int nG2= xResG2*yResG2*zResG2;
+    gridDim = gridMgr->getGridDimension();
     
     //magnetic field is defined by ModelInitializer
     
@@ -29,15 +24,8 @@ void EleMagManager::initialize(){
     calculateBhalf(PREDICTOR);
     calculateJhalf(PREDICTOR);
     
-    VectorVar** current = gridMgr->getVectorVariableOnG2(CURRENT);
-    int ijkG2, h;
     // CURRENT_AUX is smoothed CURRENT, normally CURRENT_AUX is set in ClosureManager.cpp
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 3; h++ ){
-            gridMgr->setVectorVariableForNodeG2(ijkG2, CURRENT_AUX, h,
-                                                current[ijkG2]->getValue()[h]);
-        }
-    }
+    gridMgr->copyFieldOnG2(CURRENT, CURRENT_AUX);
     
     calculateEnext(PREDICTOR);
     calculateBnext();
@@ -46,12 +34,7 @@ void EleMagManager::initialize(){
     calculateBhalf(CORRECTOR);
     calculateJhalf(CORRECTOR);
     
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 3; h++ ){
-            gridMgr->setVectorVariableForNodeG2(ijkG2, CURRENT_AUX, h,
-                                                current[ijkG2]->getValue()[h]);
-        }
-    }
+    gridMgr->copyFieldOnG2(CURRENT, CURRENT_AUX);
     
     calculateEnext(CORRECTOR);
     calculateBnext();
@@ -88,7 +71,7 @@ void EleMagManager::initBfieldDampingCoeff(){
     int nG1 = xResG1*yResG1*zResG1;
     int i, j, k;
     
-    BfieldDampingCoeff = new double[nG1*sizeof(double)];
+    BfieldDampingCoeff = new double[nG1];
     
     for( int idx = 0; idx < nG1; idx++ ){
         BfieldDampingCoeff[idx] = 1.0;
@@ -171,10 +154,28 @@ void EleMagManager::initBfieldDampingCoeff(){
     }
 }
 
-void EleMagManager::calculateMagneticField(int magField2use, int eleField2use, int magField2save){
+void EleMagManager::calculateMagneticField(int magField2use, int eleField2use,
+                                           int magField2save, double ts){
+    switch (gridDim) {
+        case 1:
+            calculateMagneticField<1>(magField2use, eleField2use, magField2save, ts);
+            break;
+        case 2:
+            calculateMagneticField<2>(magField2use, eleField2use, magField2save, ts);
+            break;
+        default:
+            calculateMagneticField<3>(magField2use, eleField2use, magField2save, ts);
+    }
+    gridMgr->invalidateDerivedOnG1(magField2save);
+}
+
+
+//  derivatives along the collapsed axes (DIM and above) vanish and are skipped
+template<int DIM>
+void EleMagManager::calculateMagneticField(int magField2use, int eleField2use,
+                                           int magField2save, double ts){
     
     double dtx, dty, dtz;
-    double ts = loader->getTimeStep();
     
     double dx = loader->spatialSteps[0];
     double dy = loader->spatialSteps[1];
@@ -188,54 +189,218 @@ void EleMagManager::calculateMagneticField(int magField2use, int eleField2use, i
     dty = 0.125*ts/dy;
     dtz = 0.125*ts/dz;
     
-    int totalG1Nodes = (xSize+1)*(ySize+1)*(zSize+1);
-
-    const int * ngborsXder = gridMgr->getNeibors4G2spatialDerX();
-    const int * ngborsYder = gridMgr->getNeibors4G2spatialDerY();
-    const int * ngborsZder = gridMgr->getNeibors4G2spatialDerZ();
-    
-    VectorVar** eField     = gridMgr->getVectorVariableOnG2(eleField2use);
-    VectorVar** bFieldPrev = gridMgr->getVectorVariableOnG1(magField2use);
+    int res[3] = {xSize, ySize, zSize};
+    int strides[3], ngborsXder[8], ngborsYder[8], ngborsZder[8];
+    gridMgr->getNodeStrides(2, 0, strides);
+    derivativeOffsets(CURL_PAIRS[0], strides, res[0] == 1, ngborsXder);
+    derivativeOffsets(CURL_PAIRS[1], strides, res[1] == 1, ngborsYder);
+    derivativeOffsets(CURL_PAIRS[2], strides, res[2] == 1, ngborsZder);
+    
+    FieldG2 eField     = gridMgr->getFieldOnG2(eleField2use);
+    FieldG1 bFieldPrev = gridMgr->getFieldOnG1(magField2use);
+    FieldG1 bFieldNext = gridMgr->getFieldOnG1(magField2save);
+    
+    //# components are read and written directly, k is the contiguous index
+    const double* Ex = eField.getComponent(0);
+    const double* Ey = eField.getComponent(1);
+    const double* Ez = eField.getComponent(2);
+    const double* BxPrev = bFieldPrev.getComponent(0);
+    const double* ByPrev = bFieldPrev.getComponent(1);
+    const double* BzPrev = bFieldPrev.getComponent(2);
+    double* BxNext = bFieldNext.getComponent(0);
+    double* ByNext = bFieldNext.getComponent(1);
+    double* BzNext = bFieldNext.getComponent(2);
 
     double Exdy, Exdz, Eydx, Eydz, Ezdx, Ezdy;
     int left, rigt;
-    double bFieldX, bFieldY, bFieldZ;
-    const double* B0;
+    double damping;
+    
+    int i, j, k, idx, idxG2;
+    vector<Tile> tiles = gridMgr->getTiles(0, 1);
+    OMP(parallel for schedule(static) private(i, j, k, idx, idxG2, left, rigt, damping,
+                                              Exdy, Exdz, Eydx, Eydz, Ezdx, Ezdy))
+    for( int tileNum = 0; tileNum < tiles.size(); tileNum++ ){
+        const Tile& tile = tiles[tileNum];
+        for( i = tile.from[0]; i < tile.to[0]; i++ ){
+            for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                for( k = tile.from[2]; k < tile.to[2]; k++ ){
+
+                    idx   = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
+                    idxG2 = IDX(i,j,k,xSize+2,ySize+2,zSize+2);
+
+                    Exdy = 0; Exdz= 0; Eydx= 0; Eydz= 0; Ezdx= 0; Ezdy = 0;
+                    for( int pairNum = 0; pairNum < 4; pairNum++ ){
+                        left = idxG2+ngborsXder[2*pairNum+0];
+                        rigt = idxG2+ngborsXder[2*pairNum+1];// index ijk is saved with 1
+                        Eydx += Ey[left] - Ey[rigt];
+                        Ezdx += Ez[left] - Ez[rigt];
+
+                        if( DIM > 1 ){
+                            left = idxG2+ngborsYder[2*pairNum+0];
+                            rigt = idxG2+ngborsYder[2*pairNum+1];
+                            Exdy += Ex[left] - Ex[rigt];
+                            Ezdy += Ez[left] - Ez[rigt];
+                        }
+
+                        if( DIM > 2 ){
+                            left = idxG2+ngborsZder[2*pairNum+0];
+                            rigt = idxG2+ngborsZder[2*pairNum+1];
+                            Exdz += Ex[left] - Ex[rigt];
+                            Eydz += Ey[left] - Ey[rigt];
+                        }
+                    }
+                    damping = BfieldDampingCoeff[idx];
+                    BxNext[idx] = BxPrev[idx] + (Eydz*dtz - Ezdy*dty)*damping;
+                    ByNext[idx] = ByPrev[idx] + (Ezdx*dtx - Exdz*dtz)*damping;
+                    BzNext[idx] = BzPrev[idx] + (Exdy*dty - Eydx*dtx)*damping;
+                }
+            }
+        }
+    }
+}
+
+
+//  advances magField2use by one timestep into magField2save. With subcycling
+//  the first sub-step uses eleField2use as without it, the others take the
+//  electric field of Ohm's law for the advanced field with the ion moments
+//  and the electron pressure frozen; current and electric field on the grid
+//  are scratch then and the electric field is restored at the end
+void EleMagManager::advanceMagneticField(int magField2use, int eleField2use, int magField2save){
     
-    for( int idx = 0; idx < totalG1Nodes; idx++ ){
-        
-        Exdy = 0; Exdz= 0; Eydx= 0; Eydz= 0; Ezdx= 0; Ezdy = 0;
-        for( int pairNum = 0; pairNum < 4; pairNum++ ){
-            left = ngborsXder[8*idx+2*pairNum+0];
-            rigt = ngborsXder[8*idx+2*pairNum+1];// index ijk is saved with 1
-            Eydx += eField[left]->getValue()[1] - eField[rigt]->getValue()[1];
-            Ezdx += eField[left]->getValue()[2] - eField[rigt]->getValue()[2];
-                
-            left = ngborsYder[8*idx+2*pairNum+0];
-            rigt = ngborsYder[8*idx+2*pairNum+1];
-            Exdy += eField[left]->getValue()[0] - eField[rigt]->getValue()[0];
-            Ezdy += eField[left]->getValue()[2] - eField[rigt]->getValue()[2];
-            
-            left = ngborsZder[8*idx+2*pairNum+0];
-            rigt = ngborsZder[8*idx+2*pairNum+1];
-            Exdz += eField[left]->getValue()[0] - eField[rigt]->getValue()[0];
-            Eydz += eField[left]->getValue()[1] - eField[rigt]->getValue()[1];
+    double ts = loader->getTimeStep();
+    int subcycles = 1;
+    
+    if( loader->maxFieldSubcycles > 1 ){
+        subcycles = getFieldSubcycles(magField2use);
+    }
+    
+    calculateMagneticField(magField2use, eleField2use, magField2save, ts/subcycles);
+    
+    if( subcycles == 1 ){
+        return;
+    }
+    
+    FieldG2 eField = gridMgr->getFieldOnG2(ELECTRIC);
+    long eFieldLength = eField.getSize()*eField.getStride();
+    eFieldSaved.assign(eField.getData(), eField.getData()+eFieldLength);
+    
+    for( int sub = 1; sub < subcycles; sub++ ){
+        calculateCurrent(magField2save, CURRENT, 0);
+        calculateElectricField(magField2save, ELECTRIC);
+        calculateMagneticField(magField2save, ELECTRIC, magField2save, ts/subcycles);
+    }
+    
+    copy(eFieldSaved.begin(), eFieldSaved.end(), eField.getData());
+}
+
+
+long EleMagManager::getCorrectorClampedNodesNum(){
+    return correctorClampedNodes;
+}
+
+
+//  max of |B|/n over the nodes of all domains
+double EleMagManager::getMaxWhistlerFactor(int magField2use){
+    
+    int xSize = loader->resolution[0];
+    int ySize = loader->resolution[1];
+    int zSize = loader->resolution[2];
+    
+    FieldG1 bField  = gridMgr->getFieldOnG1(magField2use);
+    FieldG2 revertDensity = gridMgr->getDerivedField(REVERT_DENSITY);
+    
+    const double* Bx   = bField.getComponent(0);
+    const double* By   = bField.getComponent(1);
+    const double* Bz   = bField.getComponent(2);
+    const double* revertDens = revertDensity.getComponent(0);
+    
+    double localMax = 0.0, globalMax = 0.0, whistler;
+    int i, j, k, idxG1, idxG2;
+    
+    for( i = 1; i < xSize+1; i++ ){
+        for( j = 1; j < ySize+1; j++ ){
+            for( k = 1; k < zSize+1; k++ ){
+                idxG1 = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
+                idxG2 = IDX(i,j,k,xSize+2,ySize+2,zSize+2);
+                //# Hall term of Ohm's law scales with edgeProfile(n)/n
+                whistler = sqrt(Bx[idxG1]*Bx[idxG1]+By[idxG1]*By[idxG1]+Bz[idxG1]*Bz[idxG1])
+                          *revertDens[idxG2];
+                localMax = max(localMax, whistler);
+            }
         }
-        B0 = bFieldPrev[idx]->getValue();
-        
-        bFieldX = B0[0] + (Eydz*dtz - Ezdy*dty)*BfieldDampingCoeff[idx];
-        bFieldY = B0[1] + (Ezdx*dtx - Exdz*dtz)*BfieldDampingCoeff[idx];
-        bFieldZ = B0[2] + (Exdy*dty - Eydx*dtx)*BfieldDampingCoeff[idx];
-        
-        vector<double> bf = {bFieldX, bFieldY, bFieldZ};
-        for( int coord = 0; coord < 3; coord++ ) {
-            gridMgr->setVectorVariableForNodeG1(idx, magField2save, coord, bf[coord]);
+    }
+    
+    MPI_Allreduce(&localMax, &globalMax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return globalMax;
+}
+
+
+//  sum(1/dx^2) over the resolved axes
+double EleMagManager::getInvSpatialSteps2(){
+    double invSteps2 = 0.0;
+    for( int coord = 0; coord < 3; coord++ ){
+        if( loader->totPixelsPerBoxSide[coord] > 1 ){
+            invSteps2 += 1.0/(loader->spatialSteps[coord]*loader->spatialSteps[coord]);
         }
     }
+    return invSteps2;
+}
+
+
+//  frequency of the finest grid whistler of all domains, the magnetic field
+//  with subcycling is stable for a timestep below maxFieldSubcycles over it
+double EleMagManager::getWhistlerRate(){
+    return getMaxWhistlerFactor(MAGNETIC)*M_PI*getInvSpatialSteps2();
+}
+
+
+//  number of sub-steps of the magnetic field: the finest grid whistler,
+//  omega = k^2 |B|/n, is stable for ts*|B|/n*pi*sum(1/dx^2) < 1.
+//  The fastest node of all domains sets the number, so that all domains
+//  exchange halos the same number of times
+int EleMagManager::getFieldSubcycles(int magField2use){
+    
+    double globalMax = getMaxWhistlerFactor(magField2use);
+    
+    double ts = loader->getTimeStep();
+    int subcycles = (int) ceil(ts*globalMax*M_PI*getInvSpatialSteps2());
+    subcycles = min(max(subcycles, 1), loader->maxFieldSubcycles);
+    
+    if( subcycles != fieldSubcycles ){
+        string msg = "[EleMagManager] magnetic field is advanced in "+to_string(subcycles)
+                    +" sub-steps per timeStep, max |B|/n = "+to_string(globalMax);
+        logger->writeMsg(msg.c_str(), INFO);
+        fieldSubcycles = subcycles;
+    }
+    
+    return subcycles;
 }
 
 
-void EleMagManager::calculateCurrent(int magField2use, int current2save){
+void EleMagManager::calculateCurrent(int magField2use, int current2save, int postHalo){
+    switch (gridDim) {
+        case 1:
+            calculateCurrent<1>(magField2use, current2save, postHalo);
+            break;
+        case 2:
+            calculateCurrent<2>(magField2use, current2save, postHalo);
+            break;
+        default:
+            calculateCurrent<3>(magField2use, current2save, postHalo);
+    }
+}
+
+
+//  postHalo = 1: current is not read before the next particle migration,
+//  its halo and smoothing are done in that communication round
+template<int DIM>
+void EleMagManager::calculateCurrent(int magField2use, int current2save, int postHalo){
+    
+    //# a posted current must be complete before it is overwritten,
+    //# other posted halos (driver) are left to the particle migration
+    if( gridMgr->isHaloPending(current2save) ){
+        gridMgr->flushHalos(nullptr);
+    }
     
     int idxG1, idxG2;
     double dx = loader->spatialSteps[0];
@@ -250,75 +415,118 @@ void EleMagManager::calculateCurrent(int magField2use, int current2save){
     dy = 1.0/dy;
     dz = 1.0/dz;
     
-    const int* ngborsXder = gridMgr->getNeibors4G1spatialDerX();
-    const int* ngborsYder = gridMgr->getNeibors4G1spatialDerY();
-    const int* ngborsZder = gridMgr->getNeibors4G1spatialDerZ();
-    
-    VectorVar** bField = gridMgr->getVectorVariableOnG1(magField2use);
+    //# G1 points behind the G2 node: pairs taken with negated strides
+    int res[3] = {xSize, ySize, zSize};
+    int strides[3], ngborsXder[8], ngborsYder[8], ngborsZder[8];
+    gridMgr->getNodeStrides(1, 0, strides);
+    for( int e = 0; e < 3; e++ ){
+        strides[e] = -strides[e];
+    }
+    derivativeOffsets(CURL_PAIRS[0], strides, res[0] == 1, ngborsXder);
+    derivativeOffsets(CURL_PAIRS[1], strides, res[1] == 1, ngborsYder);
+    derivativeOffsets(CURL_PAIRS[2], strides, res[2] == 1, ngborsZder);
+    
+    FieldG1 bField = gridMgr->getFieldOnG1(magField2use);
+    FieldG2 current = gridMgr->getFieldOnG2(current2save);
+    
+    const double* Bx = bField.getComponent(0);
+    const double* By = bField.getComponent(1);
+    const double* Bz = bField.getComponent(2);
+    double* Jx = current.getComponent(0);
+    double* Jy = current.getComponent(1);
+    double* Jz = current.getComponent(2);
+    
+    //# with deep ghost layers the curl goes straight into the smoothing
+    //# workspace: its single exchange replaces the halo of the current
+    GhostedBlock block;
+    int fused = !postHalo && gridMgr->openGhostedBlock({current2save}, block);
+    int shift[3] = {0, 0, 0};
+    int out[3] = {xSize+2, ySize+2, zSize+2};
+    if( fused ){
+        for( int e = 0; e < 3; e++ ){
+            shift[e] = block.lo[e]-1;
+            out[e]   = block.n[e];
+        }
+        Jx = &block.work[0];
+        Jy = &block.work[block.nodesNum];
+        Jz = &block.work[2*block.nodesNum];
+    }
     
     double Bxdy, Bxdz, Bydx, Bydz, Bzdx, Bzdy;
     int left, rigt;
-    double currentX, currentY, currentZ;
     
-    int i,j,k;
-    for( i = 1; i < xSize+1; i++ ){
-        for( j = 1; j < ySize+1; j++ ){
-            for( k = 1; k < zSize+1; k++ ){
+    //# halo of the shell is in flight while the inner tiles are computed
+    int i,j,k, shellTilesNum;
+    vector<Tile> tiles = gridMgr->getShellFirstTiles(1, 1, shellTilesNum);
+    int tilesNum = tiles.size();
+    for( int part = 0; part < 2; part++ ){
+        if( part == 1 && shellTilesNum < tilesNum && !postHalo && !fused ){
+            gridMgr->startBoundary2Neighbor({current2save});
+        }
+        int firstTile = part == 0 ? 0 : shellTilesNum;
+        int lastTile  = part == 0 ? shellTilesNum : tilesNum;
+        OMP(parallel for schedule(static) private(i, j, k, idxG1, idxG2, left, rigt,
+                                                  Bxdy, Bxdz, Bydx, Bydz, Bzdx, Bzdy))
+        for( int tileNum = firstTile; tileNum < lastTile; tileNum++ ){
+            const Tile& tile = tiles[tileNum];
+            for( i = tile.from[0]; i < tile.to[0]; i++ ){
+                for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                    for( k = tile.from[2]; k < tile.to[2]; k++ ){
                 
-                idxG1 = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
+                        idxG1 = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
                 
-                Bxdy = 0; Bxdz = 0;
-                Bydx = 0; Bydz = 0;
-                Bzdx = 0; Bzdy = 0;
+                        Bxdy = 0; Bxdz = 0;
+                        Bydx = 0; Bydz = 0;
+                        Bzdx = 0; Bzdy = 0;
         
-                for( int pairNum = 0; pairNum < 4; pairNum++ ){
+                        for( int pairNum = 0; pairNum < 4; pairNum++ ){
             
-                    left = ngborsXder[8*idxG1+2*pairNum+0];
-                    rigt = ngborsXder[8*idxG1+2*pairNum+1];// index ijk is saved in +1
-                    
-                    Bydx += bField[rigt]->getValue()[1]
-                          - bField[left]->getValue()[1];
+                            left = idxG1+ngborsXder[2*pairNum+0];
+                            rigt = idxG1+ngborsXder[2*pairNum+1];// index ijk is saved in +1
                     
-                    Bzdx += bField[rigt]->getValue()[2]
-                          - bField[left]->getValue()[2];
+                            Bydx += By[rigt] - By[left];
+                            Bzdx += Bz[rigt] - Bz[left];
             
-                    left = ngborsYder[8*idxG1+2*pairNum+0];
-                    rigt = ngborsYder[8*idxG1+2*pairNum+1];
+                            if( DIM > 1 ){
+                                left = idxG1+ngborsYder[2*pairNum+0];
+                                rigt = idxG1+ngborsYder[2*pairNum+1];
             
-                    Bxdy += bField[rigt]->getValue()[0]
-                          - bField[left]->getValue()[0];
-                    
-                    Bzdy += bField[rigt]->getValue()[2]
-                          - bField[left]->getValue()[2];
+                                Bxdy += Bx[rigt] - Bx[left];
+                                Bzdy += Bz[rigt] - Bz[left];
+                            }
             
-                    left = ngborsZder[8*idxG1+2*pairNum+0];
-                    rigt = ngborsZder[8*idxG1+2*pairNum+1];
+                            if( DIM > 2 ){
+                                left = idxG1+ngborsZder[2*pairNum+0];
+                                rigt = idxG1+ngborsZder[2*pairNum+1];
             
-                    Bxdz += bField[rigt]->getValue()[0]
-                          - bField[left]->getValue()[0];
-                    
-                    Bydz += bField[rigt]->getValue()[1]
-                          - bField[left]->getValue()[1];
+                                Bxdz += Bx[rigt] - Bx[left];
+                                Bydz += By[rigt] - By[left];
+                            }
             
-                }
-                currentX = 0.25*(Bzdy*dy - Bydz*dz);
-                currentY = 0.25*(Bxdz*dz - Bzdx*dx);
-                currentZ = 0.25*(Bydx*dx - Bxdy*dy);
-        
-                idxG2 = IDX(i,j,k,xSize+2,ySize+2,zSize+2);
+                        }
+                        idxG2 = IDX(i+shift[0], j+shift[1], k+shift[2], out[0], out[1], out[2]);
         
-                gridMgr->setVectorVariableForNodeG2(idxG2, current2save, 0, currentX);
-                gridMgr->setVectorVariableForNodeG2(idxG2, current2save, 1, currentY);
-                gridMgr->setVectorVariableForNodeG2(idxG2, current2save, 2, currentZ);
+                        Jx[idxG2] = 0.25*(Bzdy*dy - Bydz*dz);
+                        Jy[idxG2] = 0.25*(Bxdz*dz - Bzdx*dx);
+                        Jz[idxG2] = 0.25*(Bydx*dx - Bxdy*dy);
+                    }
+                }
             }
         }
     }
     
-    gridMgr->sendBoundary2Neighbor(current2save);
-    
-    gridMgr->applyBC(current2save);
+    if( postHalo ){
+        gridMgr->postBoundary2Neighbor(current2save, 1);
+        return;
+    }
     
-    gridMgr->smooth(current2save);
+    if( fused ){
+        gridMgr->smoothGhostedBlock(block);
+    }else{
+        gridMgr->finishBoundary2Neighbor({current2save});
+        gridMgr->applyBC(current2save);
+        gridMgr->smooth(current2save);
+    }
     gridMgr->applyBC(current2save);
 
 }
@@ -350,7 +558,7 @@ void EleMagManager::calculateBhalf(int phase){
     }
     
             
-    calculateMagneticField(magField2use, eleField2use, magFeld2save);
+    advanceMagneticField(magField2use, eleField2use, magFeld2save);
     
     auto end_time = high_resolution_clock::now();
     msg ="[EleMagManager] calculateBhalf() duration = "
@@ -366,7 +574,7 @@ void EleMagManager::calculateBnext(){
     int magFeld2save = MAGNETIC;
     int eleField2use = ELECTRIC;
     
-    calculateMagneticField(magField2use, eleField2use, magFeld2save);
+    advanceMagneticField(magField2use, eleField2use, magFeld2save);
     
     auto end_time = high_resolution_clock::now();
     string msg ="[EleMagManager] calculateBnext() duration = "
@@ -381,7 +589,7 @@ void EleMagManager::calculateJhalf(int phase){
     int magField2use = MAGNETIC;
     int current2save = CURRENT;
     
-    calculateCurrent(magField2use, current2save);
+    calculateCurrent(magField2use, current2save, 0);
     
     auto end_time = high_resolution_clock::now();
     string msg ="[EleMagManager] calculateJhalf() duration = "
@@ -395,7 +603,7 @@ void EleMagManager::calculateJnext(){
     int magField2use = MAGNETIC;
     int current2save = CURRENT;
     
-    calculateCurrent(magField2use, current2save);
+    calculateCurrent(magField2use, current2save, 1);
     
     auto end_time = high_resolution_clock::now();
     string msg ="[EleMagManager] calculateJnext() duration = "
@@ -408,10 +616,6 @@ void EleMagManager::calculateJnext(){
 void EleMagManager::calculateEnext(int phase){
     auto start_time = high_resolution_clock::now();
     
-    double dx = loader->spatialSteps[0];
-    double dy = loader->spatialSteps[1];
-    double dz = loader->spatialSteps[2];
-    
     int xSize = loader->resolution[0];
     int ySize = loader->resolution[1];
     int zSize = loader->resolution[2];
@@ -438,6 +642,70 @@ void EleMagManager::calculateEnext(int phase){
             throw runtime_error("no phase");
     }
     
+    long clamped = calculateElectricField(magField2use, eleField2save);
+    if( phase == CORRECTOR ){
+        correctorClampedNodes = clamped;
+    }
+    
+    FieldG2 eField    = gridMgr->getFieldOnG2(ELECTRIC);
+    FieldG2 eFieldAux = gridMgr->getFieldOnG2(ELECTRIC_AUX);
+    
+    
+    for( int coord = 0; coord < 3; coord++ ){
+        double* E          = eField.getComponent(coord);
+        const double* Eaux = eFieldAux.getComponent(coord);
+        switch (phase){
+                case PREDICTOR:
+                    OMP(parallel for schedule(static))
+                    for( int idx = 0; idx < totG2; idx++ ){
+                        E[idx] = - E[idx]+2.0*Eaux[idx];
+                    }
+                break;
+                case CORRECTOR:
+                    OMP(parallel for schedule(static))
+                    for( int idx = 0; idx < totG2; idx++ ){
+                        E[idx] = 0.5*(E[idx]+Eaux[idx]);
+                    }
+                break;
+                default :
+                    throw runtime_error("no phase");
+        }
+    }
+    
+    
+    auto end_time = high_resolution_clock::now();
+    msg ="[EleMagManager] calculateEnext() duration = "
+            +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
+    logger->writeMsg(msg.c_str(), DEBUG);
+}
+
+
+long EleMagManager::calculateElectricField(int magField2use, int eleField2save){
+    switch (gridDim) {
+        case 1:
+            return calculateElectricField<1>(magField2use, eleField2save);
+        case 2:
+            return calculateElectricField<2>(magField2use, eleField2save);
+        default:
+            return calculateElectricField<3>(magField2use, eleField2save);
+    }
+}
+
+
+//  electric field of Ohm's law for the magnetic field magField2use,
+//  current and moments on the grid; returns the number of nodes where
+//  it exceeded the breakdown field in any component
+template<int DIM>
+long EleMagManager::calculateElectricField(int magField2use, int eleField2save){
+    
+    double dx = loader->spatialSteps[0];
+    double dy = loader->spatialSteps[1];
+    double dz = loader->spatialSteps[2];
+    
+    int xSize = loader->resolution[0];
+    int ySize = loader->resolution[1];
+    int zSize = loader->resolution[2];
+    
     double cflvel[3];
     double ts = loader->getTimeStep();
     double cellBreakdownEfield[3];
@@ -447,189 +715,181 @@ void EleMagManager::calculateEnext(int phase){
         cellBreakdownEfield[coord] = loader->cellBreakdownEfieldFactor*cflvel[coord]/ts;
     }
     
-    VectorVar** bField   = gridMgr->getVectorVariableOnG1(magField2use);
-    VectorVar** presEle  = gridMgr->getVectorVariableOnG2(PRESSURE_SMO);
-    
-    VectorVar** current  = gridMgr->getVectorVariableOnG2(CURRENT);
-    VectorVar** density  = gridMgr->getVectorVariableOnG2(DENSELEC);
-    VectorVar** dension;
+    //# cell centred B and 1/n are shared with the closure
+    FieldG2 cellB    = gridMgr->getDerivedField(magField2use == MAGNETIC
+                                                ? CELL_MAGNETIC : CELL_MAGNETIC_AUX);
+    FieldG2 revertDensity = gridMgr->getDerivedField(REVERT_DENSITY);
+    FieldG2 presEle  = gridMgr->getFieldOnG2(PRESSURE_SMO);
+    
+    FieldG2 current  = gridMgr->getFieldOnG2(CURRENT);
+    #ifdef HEAVYLOG
+    FieldG2 density  = gridMgr->getFieldOnG2(DENSELEC);
+    #endif
+    FieldG2 dension;
     int numOfSpecies = loader->getNumberOfSpecies();
 
     if ( loader->numOfSpots > 0 ) {
-        dension = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(numOfSpecies-1));
+        dension = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(numOfSpecies-1));
     }else{
-        dension = gridMgr->getVectorVariableOnG2(DENSELEC);
+        dension = gridMgr->getFieldOnG2(DENSELEC);
     }
     
-    VectorVar** velocity = gridMgr->getVectorVariableOnG2(VELOCION);
+    FieldG2 velocity = gridMgr->getFieldOnG2(VELOCION);
+    FieldG2 eFieldNew = gridMgr->getFieldOnG2(eleField2save);
+    #ifdef USE_COLLISIONAL_RESIST_FACTOR
+    FieldG2 resistivity = gridMgr->getFieldOnG2(RESISTIVITY);
+    #endif
     
     int compIDX[3][3]={{0, 1, 2},{1,3,4},{2,4,5}};
     double WEIHTS[9] = {0.125, 0.125, 0.125, 0.125, 0.250, 0.250, 0.250, 0.250, 0.500};
     double wei;
     int left, rigt;
     
-    const int* negbors4PresX = gridMgr->getNghbd4DivPeInXonG2();
-    const int* negbors4PresY = gridMgr->getNghbd4DivPeInYonG2();
-    const int* negbors4PresZ = gridMgr->getNghbd4DivPeInZonG2();
-        
-    const int* neighbourhood = gridMgr->getNeighbourhoodOnG1();
+    int coord, neighbour;
+    int strides[3], divPpairs[3][18];
+    int res[3] = {xSize, ySize, zSize};
     
-    int idxG1, idxG2, idxNeigbor, coord, neighbour, curPcomp;
+    gridMgr->getNodeStrides(2, 0, strides);
+    for( coord = 0; coord < 3; coord++ ){
+        derivativeOffsets(DIV_P_PAIRS[coord], strides, res[coord] == 1, divPpairs[coord]);
+    }
     
-    double locB[3], locE[3], divP[3], dens;
-    double dL, dP;
+    int idxG2, curPcomp;
     
-    int istart = 1, iend = xSize+1, jstart = 1, jend = ySize+1, kstart = 1, kend = zSize+1;
+    double locB[3], locE[3], divP[3], velI[3], J[3], ideal[3];
+    long clamped = 0;
     
-
-    int i,j,k;
-    for ( i=istart; i<iend; i++){
-        for ( j=jstart; j<jend; j++){
-            for ( k=kstart; k<kend; k++){
+    //# halo of the shell is in flight while the inner tiles are computed
+    int i,j,k, shellTilesNum;
+    vector<Tile> tiles = gridMgr->getShellFirstTiles(1, 1, shellTilesNum);
+    int tilesNum = tiles.size();
+    for( int part = 0; part < 2; part++ ){
+        if( part == 1 && shellTilesNum < tilesNum ){
+            gridMgr->startBoundary2Neighbor({eleField2save});
+        }
+        int firstTile = part == 0 ? 0 : shellTilesNum;
+        int lastTile  = part == 0 ? shellTilesNum : tilesNum;
+        OMP(parallel for schedule(static) private(i, j, k, idxG2, curPcomp, coord, neighbour, wei,
+                                                  left, rigt, locB, locE, divP, velI, J, ideal)
+                                          reduction(+:clamped))
+        for( int tileNum = firstTile; tileNum < lastTile; tileNum++ ){
+            const Tile& tile = tiles[tileNum];
+            for( i = tile.from[0]; i < tile.to[0]; i++ ){
+                for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                    for( k = tile.from[2]; k < tile.to[2]; k++ ){
                 
-                idxG1 = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
-                idxG2 = IDX(i,j,k,xSize+2,ySize+2,zSize+2);
+                        idxG2 = IDX(i,j,k,xSize+2,ySize+2,zSize+2);
         
-                divP[0] = 0.0, divP[1] = 0.0, divP[2] = 0.0;
-                locB[0] = 0.0; locB[1] = 0.0; locB[2] = 0.0;
-                locE[0] = 0.0; locE[1] = 0.0; locE[2] = 0.0;
+                        divP[0] = 0.0, divP[1] = 0.0, divP[2] = 0.0;
+                        locE[0] = 0.0; locE[1] = 0.0; locE[2] = 0.0;
         
-                for (coord=0; coord<3; coord++){
+                        for (coord=0; coord<3; coord++){
             
-                    for (neighbour=0; neighbour<8; neighbour++){
-                        idxNeigbor = neighbourhood[8*idxG1+neighbour];
-                        locB[coord] += 0.125*bField[idxNeigbor]->getValue()[coord];
-                    }
-                    
+                            locB[coord] = cellB(idxG2, coord);
                     
-                    for( neighbour=0; neighbour<9; neighbour++ ){
+                            for( neighbour=0; neighbour<9; neighbour++ ){
                 
-                        wei  = WEIHTS[neighbour];
+                                wei  = WEIHTS[neighbour];
                     
-                        //dx
-                        curPcomp = compIDX[coord][0];   
-                        left = negbors4PresX[18*idxG2+2*neighbour+0];
-                        rigt = negbors4PresX[18*idxG2+2*neighbour+1];
+                                //dx
+                                curPcomp = compIDX[coord][0];   
+                                left = idxG2+divPpairs[0][2*neighbour+0];
+                                rigt = idxG2+divPpairs[0][2*neighbour+1];
                     
-                        divP[coord] += (presEle[left]->getValue()[curPcomp]
-                                    -presEle[rigt]->getValue()[curPcomp])*wei*0.25/dx;
+                                divP[coord] += (presEle(left, curPcomp)
+                                            -presEle(rigt, curPcomp))*wei*0.25/dx;
                     
-                        //dy
-                        curPcomp = compIDX[coord][1];
-                        left = negbors4PresY[18*idxG2+2*neighbour+0];
-                        rigt = negbors4PresY[18*idxG2+2*neighbour+1];
-                        divP[coord] += (presEle[left]->getValue()[curPcomp]
-                                    -presEle[rigt]->getValue()[curPcomp])*wei*0.25/dy;
+                                //dy
+                                if( DIM > 1 ){
+                                    curPcomp = compIDX[coord][1];
+                                    left = idxG2+divPpairs[1][2*neighbour+0];
+                                    rigt = idxG2+divPpairs[1][2*neighbour+1];
+                                    divP[coord] += (presEle(left, curPcomp)
+                                                -presEle(rigt, curPcomp))*wei*0.25/dy;
+                                }
                 
-                        //dz
-                        curPcomp = compIDX[coord][2];
-                        left = negbors4PresZ[18*idxG2+2*neighbour+0];
-                        rigt = negbors4PresZ[18*idxG2+2*neighbour+1];
-                        divP[coord] += (presEle[left]->getValue()[curPcomp]
-                                    -presEle[rigt]->getValue()[curPcomp])*wei*0.25/dz;
-                    }
+                                //dz
+                                if( DIM > 2 ){
+                                    curPcomp = compIDX[coord][2];
+                                    left = idxG2+divPpairs[2][2*neighbour+0];
+                                    rigt = idxG2+divPpairs[2][2*neighbour+1];
+                                    divP[coord] += (presEle(left, curPcomp)
+                                                -presEle(rigt, curPcomp))*wei*0.25/dz;
+                                }
+                            }
             
-                }
+                        }
 
-                dens = density[idxG2]->getValue()[0];
-                const double* velI = velocity[idxG2]->getValue();
-                const double* J    = current[idxG2]->getValue();
-                double revertdens = dens < EPS8 ? 0.0: edgeProfile(dens)/dens;
+                        for ( coord = 0; coord < 3; coord++ ) {
+                            velI[coord] = velocity(idxG2, coord);
+                            J[coord]    = current(idxG2, coord);
+                        }
+                        double revertdens = revertDensity(idxG2, 0);
 
-                vector<double> ideal = {0.0, 0.0, 0.0};
-                ideal[0] = -(velI[1]*locB[2] - velI[2]*locB[1]);
-                ideal[1] = -(velI[2]*locB[0] - velI[0]*locB[2]);
-                ideal[2] = -(velI[0]*locB[1] - velI[1]*locB[0]);
+                        ideal[0] = -(velI[1]*locB[2] - velI[2]*locB[1]);
+                        ideal[1] = -(velI[2]*locB[0] - velI[0]*locB[2]);
+                        ideal[2] = -(velI[0]*locB[1] - velI[1]*locB[0]);
                 
-                double resistX = loader->resistivity, resistY = resistX, resistZ = resistX;
-
-                #ifdef USE_COLLISIONAL_RESIST_FACTOR
-                    double Pxx = presEle[idxG2]->getValue()[0];
-                    double Pyy = presEle[idxG2]->getValue()[3];
-                    double Pzz = presEle[idxG2]->getValue()[5];
-                    double dens2use = dension[idxG2]->getValue()[0];
-                    resistX *= pow(dens2use/Pxx*edgeProfilePressure(Pxx), 1.5);
-                    resistY *= pow(dens2use/Pyy*edgeProfilePressure(Pyy), 1.5);
-                    resistZ *= pow(dens2use/Pzz*edgeProfilePressure(Pzz), 1.5);
-                    gridMgr->setVectorVariableForNodeG2(idxG2, RESISTIVITY, 0, dens2use/Pxx*edgeProfilePressure(Pxx));
-                    gridMgr->setVectorVariableForNodeG2(idxG2, RESISTIVITY, 1, dens2use/Pyy*edgeProfilePressure(Pyy));
-                    gridMgr->setVectorVariableForNodeG2(idxG2, RESISTIVITY, 2, dens2use/Pzz*edgeProfilePressure(Pzz));
-                #endif
+                        double resistX = loader->resistivity, resistY = resistX, resistZ = resistX;
+
+                        #ifdef USE_COLLISIONAL_RESIST_FACTOR
+                            double Pxx = presEle(idxG2, 0);
+                            double Pyy = presEle(idxG2, 3);
+                            double Pzz = presEle(idxG2, 5);
+                            double dens2use = dension(idxG2, 0);
+                            resistX *= pow(dens2use/Pxx*edgeProfilePressure(Pxx), 1.5);
+                            resistY *= pow(dens2use/Pyy*edgeProfilePressure(Pyy), 1.5);
+                            resistZ *= pow(dens2use/Pzz*edgeProfilePressure(Pzz), 1.5);
+                            resistivity(idxG2, 0) = dens2use/Pxx*edgeProfilePressure(Pxx);
+                            resistivity(idxG2, 1) = dens2use/Pyy*edgeProfilePressure(Pyy);
+                            resistivity(idxG2, 2) = dens2use/Pzz*edgeProfilePressure(Pzz);
+                        #endif
                                 
                 
-                locE[0] = - (velI[1]*locB[2] - velI[2]*locB[1])
-                          + (   J[1]*locB[2] -    J[2]*locB[1])*revertdens
-                          - divP[0]*revertdens
-                          + resistX*J[0];
+                        locE[0] = - (velI[1]*locB[2] - velI[2]*locB[1])
+                                  + (   J[1]*locB[2] -    J[2]*locB[1])*revertdens
+                                  - divP[0]*revertdens
+                                  + resistX*J[0];
                 
-                locE[1] = - (velI[2]*locB[0] - velI[0]*locB[2])
-                          + (   J[2]*locB[0] -    J[0]*locB[2])*revertdens
-                          - divP[1]*revertdens
-                          + resistY*J[1];
+                        locE[1] = - (velI[2]*locB[0] - velI[0]*locB[2])
+                                  + (   J[2]*locB[0] -    J[0]*locB[2])*revertdens
+                                  - divP[1]*revertdens
+                                  + resistY*J[1];
                 
-                locE[2] = - (velI[0]*locB[1] - velI[1]*locB[0])
-                          + (   J[0]*locB[1] -    J[1]*locB[0])*revertdens
-                          - divP[2]*revertdens
-                          + resistZ*J[2];
+                        locE[2] = - (velI[0]*locB[1] - velI[1]*locB[0])
+                                  + (   J[0]*locB[1] -    J[1]*locB[0])*revertdens
+                                  - divP[2]*revertdens
+                                  + resistZ*J[2];
                 
-                for ( coord = 0; coord < 3; coord++ ) {
-                    if( abs(locE[coord]) < cellBreakdownEfield[coord] ){
-                        gridMgr->setVectorVariableForNodeG2(idxG2, eleField2save, coord, locE[coord]);
-                    }else{
-                        if(abs(ideal[coord]) < cellBreakdownEfield[coord]){
-                            gridMgr->setVectorVariableForNodeG2(idxG2, eleField2save, coord, ideal[coord]);
+                        int nodeClamped = 0;
+                        for ( coord = 0; coord < 3; coord++ ) {
+                            if( abs(locE[coord]) < cellBreakdownEfield[coord] ){
+                                eFieldNew(idxG2, coord) = locE[coord];
+                            }else{
+                                nodeClamped = 1;
+                                if(abs(ideal[coord]) < cellBreakdownEfield[coord]){
+                                    eFieldNew(idxG2, coord) = ideal[coord];
+                                }
+                                #ifdef HEAVYLOG
+                                    write2Log(idxG2, i, j, k, velI, locB, locB, divP, J, density(idxG2, 0));
+                                #endif
+                            }
                         }
-                        #ifdef HEAVYLOG
-                            write2Log(idxG2, i, j, k, velI, locB, locB, divP, J, dens);
-                        #endif
+                        clamped += nodeClamped;
+                
                     }
                 }
-                
             }
         }
     }
  
-    gridMgr->sendBoundary2Neighbor(eleField2save);
+    gridMgr->finishBoundary2Neighbor({eleField2save});
     gridMgr->applyBC(eleField2save);
 
     gridMgr->smooth(eleField2save);
     gridMgr->applyBC(eleField2save);
     
-    VectorVar** eField    = gridMgr->getVectorVariableOnG2(ELECTRIC);
-    VectorVar** eFieldAux = gridMgr->getVectorVariableOnG2(ELECTRIC_AUX);
-    
-    
-    locE[0] = 0.0; locE[1] = 0.0; locE[2] = 0.0;
-    switch (phase){
-            case PREDICTOR:
-                for( int idx = 0; idx < totG2; idx++ ){
-                    for( coord = 0; coord < 3; coord++ ){
-                        locE[coord] =
-                        - eField[idx]->getValue()[coord]+2.0*eFieldAux[idx]->getValue()[coord];
-                        
-                        gridMgr->setVectorVariableForNodeG2(idx, ELECTRIC, coord, locE[coord]);
-                    }
-                }
-            break;
-            case CORRECTOR:
-                for( int idx = 0; idx < totG2; idx++ ){
-                    for( coord = 0; coord < 3; coord++ ){
-                        locE[coord] =
-                        0.5*(eField[idx]->getValue()[coord]+eFieldAux[idx]->getValue()[coord]);
-                        
-                        gridMgr->setVectorVariableForNodeG2(idx, ELECTRIC, coord, locE[coord]);
-                    }
-                }
-            break;
-            default :
-                throw runtime_error("no phase");
-    }
-    
-    
-    auto end_time = high_resolution_clock::now();
-    msg ="[EleMagManager] calculateEnext() duration = "
-            +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
-    logger->writeMsg(msg.c_str(), DEBUG);
+    return clamped;
 }
 
 
@@ -9,6 +9,8 @@
 #include <cmath>
 #include <string>
 #include <memory>
+#include <vector>
+#include <algorithm>
 
 #include "../../grid/GridManager.hpp"
 #include "../../input/Loader.hpp"
@@ -25,9 +27,30 @@ private:
     double* BfieldDampingCoeff;
     void initBfieldDampingCoeff();
     
+    //# kernels are compiled for 1, 2 and 3 dimensions of the grid
+    int gridDim;
+    
+    //# sub-steps of the magnetic field in the last timestep
+    int fieldSubcycles = 1;
+    std::vector<double> eFieldSaved;
+    
+    //# nodes where Ohm's law of the last corrector exceeded the breakdown field
+    long correctorClampedNodes = 0;
+    
     void initialize();
-    void calculateMagneticField(int, int, int);
-    void calculateCurrent(int, int);
+    void advanceMagneticField(int, int, int);
+    int getFieldSubcycles(int);
+    double getMaxWhistlerFactor(int);
+    double getInvSpatialSteps2();
+    void calculateMagneticField(int, int, int, double);
+    void calculateCurrent(int, int, int);
+    long calculateElectricField(int, int);
+    template<int DIM>
+    void calculateMagneticField(int, int, int, double);
+    template<int DIM>
+    void calculateCurrent(int, int, int);
+    template<int DIM>
+    long calculateElectricField(int, int);
     
     void write2Log(int, int, int, int, const double*,
                    double*, double*, double*, const double*, double);
@@ -41,6 +64,9 @@ public:
     void calculateJnext();
     
     void calculateEnext(int);
+    
+    double getWhistlerRate();
+    long getCorrectorClampedNodesNum();
 
 };
 
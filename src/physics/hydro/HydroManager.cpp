@@ -6,8 +6,10 @@ using namespace chrono;
 
 HydroManager::HydroManager(shared_ptr<Loader> ldr,
                            shared_ptr<GridManager> gridMnr,
-                           shared_ptr<Pusher> pshr):loader(move(ldr)),
-                           gridMgr(move(gridMnr)), pusher(move(pshr)){
+                           shared_ptr<Pusher> pshr,
+                           shared_ptr<Workspace> wrkspc):loader(move(ldr)),
+                           gridMgr(move(gridMnr)), pusher(move(pshr)),
+                           workspace(move(wrkspc)){
                                 
     logger.reset(new Logger());
     initialize();
@@ -61,8 +63,9 @@ void HydroManager::calculateAvgFluidVelocity4AllSpiecies(int phase){
     double domainShiftY = loader->boxCoordinates[1][0];
     double domainShiftZ = loader->boxCoordinates[2][0];
     
-    double* weights          = new double[G2nodesNumber*numOfSpecies];
-    double* velocityWeighted = new double[G2nodesNumber*numOfSpecies*3];
+    WorkspaceScope scope(*workspace);
+    double* weights          = scope.borrow<double>(G2nodesNumber*numOfSpecies);
+    double* velocityWeighted = scope.borrow<double>(G2nodesNumber*numOfSpecies*3);
     
     for( idx=0; idx < G2nodesNumber; idx++ ){
         for( spn=0; spn < numOfSpecies; spn++ ){
@@ -172,6 +175,7 @@ void HydroManager::calculateAvgFluidVelocity4AllSpiecies(int phase){
          }
     }
     
+    vector<int> densVelVars;
     for( spn = 0; spn < numOfSpecies; spn++ ){
         for( idx = 0; idx < G2nodesNumber; idx++ ){
             
@@ -183,13 +187,14 @@ void HydroManager::calculateAvgFluidVelocity4AllSpiecies(int phase){
                                                     velocityWeighted[(numOfSpecies*idx+spn)*3+coord]);
             }
         }
-        
-        gridMgr->gatherBoundaryUsingNeighbor(gridMgr->DENS_VEL(spn));
+        densVelVars.push_back(gridMgr->DENS_VEL(spn));
+    }
+    
+    gridMgr->gatherBoundaryUsingNeighbor(densVelVars);
+    
+    for( spn = 0; spn < numOfSpecies; spn++ ){
         gridMgr->applyBC(gridMgr->DENS_VEL(spn));
     }
-   
-    delete [] weights;
-    delete [] velocityWeighted;
 }
 
 
@@ -218,14 +223,15 @@ void HydroManager::gatherMoments(int phase){
     
     int numOfSpecies = loader->getNumberOfSpecies();
     
-    map<int, VectorVar**> dens_vel, dens_aux;
+    map<int, FieldG2> dens_vel, dens_aux;
     
     for( spn = 0; spn < numOfSpecies; spn++ ){
-            dens_vel[spn] = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(spn));
-            dens_aux[spn] = gridMgr->getVectorVariableOnG2(gridMgr->DENS_AUX(spn));
+            dens_vel[spn] = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(spn));
+            dens_aux[spn] = gridMgr->getFieldOnG2(gridMgr->DENS_AUX(spn));
     }
     
-    double* densOfIons = new double[numOfSpecies*G2nodesNumber];
+    WorkspaceScope scope(*workspace);
+    double* densOfIons = scope.borrow<double>(numOfSpecies*G2nodesNumber);
     
     double vel;
     
@@ -234,7 +240,7 @@ void HydroManager::gatherMoments(int phase){
             
             pw = pusher->getParticleWeight4Type(spn);
     
-            normPtcl = dens_vel[spn][idx]->getValue()[0];
+            normPtcl = dens_vel[spn](idx, 0);
             
             if( normPtcl < EPS8 ){
                 for( coord = 0; coord < 3; coord++ ){
@@ -243,7 +249,7 @@ void HydroManager::gatherMoments(int phase){
                 }
             }else{
                 for( coord = 0; coord < 3; coord++ ){
-                    vel = dens_vel[spn][idx]->getValue()[1+coord]/normPtcl;
+                    vel = dens_vel[spn](idx, 1+coord)/normPtcl;
                     gridMgr->setVectorVariableForNodeG2(idx, gridMgr->DENS_VEL(spn), 1+coord, vel);
                 }
             }
@@ -260,22 +266,20 @@ void HydroManager::gatherMoments(int phase){
     double avg = 0;
     for( spn = 0; spn < numOfSpecies; spn++ ){
         for( idx = 0; idx < G2nodesNumber; idx++ ){
-            avg = 0.5*(dens_vel[spn][idx]->getValue()[0]+dens_aux[spn][idx]->getValue()[0]);
+            avg = 0.5*(dens_vel[spn](idx, 0)+dens_aux[spn](idx, 0));
             densOfIons[numOfSpecies*idx+spn] = avg;
         }
     }
 
     if( phase == PREDICTOR ){
         for( spn = 0; spn < numOfSpecies; spn++ ){
-            int dens2up  = gridMgr->DENS_AUX(spn);
-            for( idx = 0; idx < G2nodesNumber; idx++ ){
-                gridMgr->setVectorVariableForNodeG2(idx, dens2up, 0, dens_vel[spn][idx]->getValue()[0]);
-            }
+            const double* dens = dens_vel[spn].getComponent(0);
+            copy(dens, dens+G2nodesNumber, dens_aux[spn].getComponent(0));
         }
     }
     
-    double* densEle  = new double[G2nodesNumber];
-    double* fluidVel = new double[3*G2nodesNumber];
+    double* densEle  = scope.borrow<double>(G2nodesNumber);
+    double* fluidVel = scope.borrow<double>(3*G2nodesNumber);
     
     for( idx = 0; idx < G2nodesNumber; idx++ ){
         densEle[idx] = 0.0;
@@ -299,7 +303,7 @@ void HydroManager::gatherMoments(int phase){
             double densEleRevert = densEle[idx] < EPS8 ? 0.0 : 1.0/densEle[idx];
             double ionDens = densOfIons[numOfSpecies*idx+spn];
             for( coord = 0; coord < 3; coord++ ){
-                vel = dens_vel[spn][idx]->getValue()[1+coord];
+                vel = dens_vel[spn](idx, 1+coord);
                 fluidVel[3*idx+coord] += ionDens*vel*prtclCharge*densEleRevert;
             }
         }
@@ -308,14 +312,11 @@ void HydroManager::gatherMoments(int phase){
         }
     }
 
-    gridMgr->smoothDensAndIonVel();
+    vector<int> vars2smooth = {DENSELEC, VELOCION};
+    gridMgr->smooth(vars2smooth);
     gridMgr->applyBC(DENSELEC);
     gridMgr->applyBC(VELOCION);
     
-    delete [] densOfIons;
-    delete [] densEle;
-    delete [] fluidVel;
-    
     auto end_time = high_resolution_clock::now();
     string msg ="[HydroManager] gatherMoments()... duration = "
                 +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
@@ -380,9 +381,9 @@ void HydroManager::setIonPressureTensor(){
             }
         }
     }
-    map<int, VectorVar**> dens_vel;
+    map<int, FieldG2> dens_vel;
     for( type = 0; type < numOfSpecies; type++ ){
-            dens_vel[type] = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(type));
+            dens_vel[type] = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(type));
     }
 
     for( idx=0; idx < totalPrtclNumber; idx++ ){
@@ -430,9 +431,9 @@ void HydroManager::setIonPressureTensor(){
             
             idxG2 = IDX(idx_x ,idx_y ,idx_z, xSizeG2, ySizeG2, zSizeG2);
             
-            vx = dens_vel[type][idxG2]->getValue()[1];
-            vy = dens_vel[type][idxG2]->getValue()[2];
-            vz = dens_vel[type][idxG2]->getValue()[3];
+            vx = dens_vel[type](idxG2, 1);
+            vy = dens_vel[type](idxG2, 2);
+            vz = dens_vel[type](idxG2, 3);
             
             alpha = alphas[neigh_num];
             betta = bettas[neigh_num];
@@ -27,12 +27,14 @@ private:
     std::shared_ptr<GridManager> gridMgr;
     std::shared_ptr<Pusher> pusher;
     std::shared_ptr<BoundaryManager> boundaryMgr;
+    std::shared_ptr<Workspace> workspace;
     
     void initialize();
     void calculateAvgFluidVelocity4AllSpiecies(int);
     
 public:
-    HydroManager(std::shared_ptr<Loader>, std::shared_ptr<GridManager>, std::shared_ptr<Pusher>);
+    HydroManager(std::shared_ptr<Loader>, std::shared_ptr<GridManager>,
+                 std::shared_ptr<Pusher>, std::shared_ptr<Workspace>);
     void gatherMoments(int);
     void setIonPressureTensor();
     
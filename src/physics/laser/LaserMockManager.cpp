@@ -36,10 +36,10 @@ void LaserMockManager::initialize(){
     
     int nG2 = xResG2*yResG2*zResG2;
     
-    electronPressureProfile = new double[nG2*sizeof(double)];
-    targetIonDensityProfile = new double[nG2*sizeof(double)];
-    ionThermalVelocityProfile = new double[nG2*3*sizeof(double)];
-    ionFluidVelocityProfile = new double[nG2*3*sizeof(double)];
+    electronPressureProfile = new double[nG2];
+    targetIonDensityProfile = new double[nG2];
+    ionThermalVelocityProfile = new double[nG2*3];
+    ionFluidVelocityProfile = new double[nG2*3];
 
     double pres, dens;
     vector<double> fluidVel;
@@ -98,7 +98,14 @@ void LaserMockManager::initialize(){
 }
 
 
-void LaserMockManager::addIons(int i_time){
+//  step starting at time is past the pulse, half a step absorbs the
+//  rounding of the simulation time summed up with adaptiveTimeStep
+bool LaserMockManager::isPulseOver(double time){
+    return time-loader->laserPulseDuration > 0.5*loader->getTimeStep();
+}
+
+
+void LaserMockManager::addIons(double time){
     auto start_time = high_resolution_clock::now();
 
     const double VELOCITY4COLDTEMPERATURE = EPSILON;
@@ -123,8 +130,8 @@ void LaserMockManager::addIons(int i_time){
     
     int ptclIDX;
     
-    VectorVar** dens4Injected = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(PARTICLE_TYPE2LOAD));
-    VectorVar** dens4nonInjected = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(loader->prtclType2Load));
+    FieldG2 dens4Injected = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(PARTICLE_TYPE2LOAD));
+    FieldG2 dens4nonInjected = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(loader->prtclType2Load));
 
     vector<shared_ptr<Particle>> particles2add;
     int particle_idx = 0;
@@ -144,10 +151,10 @@ void LaserMockManager::addIons(int i_time){
                 int type2use = 0;
                 if( pres > 0.0 ){
                     type2use = PARTICLE_TYPE2LOAD;
-                    desireDens = targetIonDensityProfile[idxOnG2] - dens4Injected[idxOnG2]->getValue()[0];
+                    desireDens = targetIonDensityProfile[idxOnG2] - dens4Injected(idxOnG2, 0);
                 }else{
                     type2use = loader->prtclType2Load;
-                    desireDens = targetIonDensityProfile[idxOnG2] - dens4nonInjected[idxOnG2]->getValue()[0];
+                    desireDens = targetIonDensityProfile[idxOnG2] - dens4nonInjected(idxOnG2, 0);
                 }
                 double particleWeight = pusher->getParticleWeight4Type(type2use);
                 
@@ -180,7 +187,7 @@ void LaserMockManager::addIons(int i_time){
                         r2 = RNM;
                         r1   = (fabs(r1 - 1.0) < EPS8) ? r1 - EPS8 : r1;
                         r1   = (r1 > EPS8)? r1 : r1 + EPS8;
-                        if( i_time > loader->laserPulseDuration_tsnum ){
+                        if( isPulseOver(time) ){
                             vpb[0] = sqrt(-2*log(r1))*VELOCITY4COLDTEMPERATURE*cos(2*PI*r2);
                             vpb[1] = sqrt(-2*log(r1))*VELOCITY4COLDTEMPERATURE*sin(2*PI*r2);
                             r1 = RNM;
@@ -204,7 +211,7 @@ void LaserMockManager::addIons(int i_time){
                     }else{
                         double randoms[3] = {RNM,RNM,RNM};
                         for( int comp = 0; comp < 3; comp++ ){
-                            if( i_time > loader->laserPulseDuration_tsnum ){
+                            if( isPulseOver(time) ){
                                 vpb[comp] = (1.0-2.0*randoms[comp])*VELOCITY4COLDTEMPERATURE;
                             }else{
                                 vpb[comp] = (1.0-2.0*randoms[comp])*ionThermalVelocityProfile[3*idxOnG2+comp];
@@ -233,12 +240,15 @@ void LaserMockManager::addIons(int i_time){
 
 
 
-void LaserMockManager::accelerate(int i_time){
+void LaserMockManager::accelerate(double time){
     auto start_time = high_resolution_clock::now();
     
-    if (i_time > loader->laserPulseDuration_tsnum){
+    if( isPulseOver(time) ){
         return;
     }
+    
+    //# energy is summed over the halo too, a posted driver is completed
+    gridMgr->flushHalos(nullptr);
     int i, j, k, idxOnG2;
     
     int xRes = loader->resolution[0],
@@ -247,11 +257,10 @@ void LaserMockManager::accelerate(int i_time){
     int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
     int G2nodesNumber = xResG2*yResG2*zResG2;
 
-    VectorVar** pdriverr    = gridMgr->getVectorVariableOnG2(DRIVER);
+    FieldG2 pdriverr    = gridMgr->getFieldOnG2(DRIVER);
     double energyOnDomain = 0;
     for( idxOnG2 = 0; idxOnG2 < G2nodesNumber; idxOnG2++ ){
-        const double* dr = pdriverr[idxOnG2]->getValue();
-        energyOnDomain += (dr[0]+dr[3]+dr[5])/3;
+        energyOnDomain += (pdriverr(idxOnG2, 0)+pdriverr(idxOnG2, 3)+pdriverr(idxOnG2, 5))/3;
     }
     
     for( i = 1; i < xRes + 1; i++ ){
@@ -259,9 +268,9 @@ void LaserMockManager::accelerate(int i_time){
             for( k = 1; k < zRes + 1; k++ ){                
                 idxOnG2 = IDX(i ,j ,k , xResG2, yResG2, zResG2);                
                 double pres2set = electronPressureProfile[idxOnG2];
-                gridMgr->addVectorVariableForNodeG2(idxOnG2, DRIVER, 0, pres2set);
-                gridMgr->addVectorVariableForNodeG2(idxOnG2, DRIVER, 3, pres2set);
-                gridMgr->addVectorVariableForNodeG2(idxOnG2, DRIVER, 5, pres2set);
+                pdriverr(idxOnG2, 0) += pres2set;
+                pdriverr(idxOnG2, 3) += pres2set;
+                pdriverr(idxOnG2, 5) += pres2set;
             }
         }
     }
@@ -271,8 +280,7 @@ void LaserMockManager::accelerate(int i_time){
     
     double energyOnDomainNew = 0;
     for( idxOnG2 = 0; idxOnG2 < G2nodesNumber; idxOnG2++ ){
-        const double* dr = pdriverr[idxOnG2]->getValue();
-        energyOnDomainNew += (dr[0]+dr[3]+dr[5])/3;
+        energyOnDomainNew += (pdriverr(idxOnG2, 0)+pdriverr(idxOnG2, 3)+pdriverr(idxOnG2, 5))/3;
     }
 
     double laserdelta = (energyOnDomainNew - energyOnDomain)*loader->getTimeStep();
@@ -35,6 +35,7 @@ private:
     
     
     void initialize();
+    bool isPulseOver(double);
 
     
 public:
@@ -44,8 +45,8 @@ public:
     
     ~LaserMockManager();
     
-    void addIons(int);
-    void accelerate(int);
+    void addIons(double);
+    void accelerate(double);
     
 
 };
@@ -10,8 +10,10 @@ using namespace chrono;
 
 
 ClosureManager::ClosureManager(std::shared_ptr<Loader> ldr,
-                               std::shared_ptr<GridManager> gridMnr):
-                               loader(move(ldr)), gridMgr(move(gridMnr)){
+                               std::shared_ptr<GridManager> gridMnr,
+                               std::shared_ptr<Workspace> wrkspc):
+                               loader(move(ldr)), gridMgr(move(gridMnr)),
+                               workspace(move(wrkspc)){
     logger.reset(new Logger());
     initialize();
     logger->writeMsg("[ClosureManager] create...OK", DEBUG);
@@ -20,7 +22,6 @@ ClosureManager::ClosureManager(std::shared_ptr<Loader> ldr,
 ClosureManager::~ClosureManager(){
     // need for driver calculation
     delete[] driverNext;
-    delete[] pressuNext;
     delete[] electrnVel;
     delete[] pressuInit;
     delete[] bfieldPrev;
@@ -36,10 +37,9 @@ void ClosureManager::initialize(){
     
     int nG2= xResG2*yResG2*zResG2;
     
-    driverNext = new double[nG2*6*sizeof(double)];
-    pressuNext = new double[nG2*6*sizeof(double)];
-    pressuInit = new double[nG2*6*sizeof(double)];
-    electrnVel = new double[nG2*3*sizeof(double)];
+    driverNext = new double[nG2*6];
+    pressuInit = new double[nG2*6];
+    electrnVel = new double[nG2*3];
     
     emass = loader->electronmass;
     
@@ -48,14 +48,11 @@ void ClosureManager::initialize(){
     
     int h, ijkG1, ijkG2;
    
-    VectorVar** pressure = gridMgr->getVectorVariableOnG2(PRESSURE);
-    double pres;
+    FieldG2 pressure = gridMgr->getFieldOnG2(PRESSURE);
     
     for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
         for( h = 0; h < 6; h++ ){
-            pres = pressure[ijkG2]->getValue()[h];
-            pressuNext[6*ijkG2+h] = pres;
-            driverNext[6*ijkG2+h] = pres;
+            driverNext[6*ijkG2+h] = pressure(ijkG2, h);
         }
     }
 
@@ -63,12 +60,12 @@ void ClosureManager::initialize(){
     
     int nG1= xResG1*yResG1*zResG1;
     
-    bfieldPrev = new double[nG1*3*sizeof(double)];
+    bfieldPrev = new double[nG1*3];
     
-    VectorVar** bFieldKeep = gridMgr->getVectorVariableOnG1(MAGNETIC);
+    FieldG1 bFieldKeep = gridMgr->getFieldOnG1(MAGNETIC);
     for( ijkG1 = 0; ijkG1 < nG1; ijkG1++ ){
         for( h = 0; h < 3; h++ ){
-            bfieldPrev[3*ijkG1+h] = bFieldKeep[ijkG1]->getValue()[h];
+            bfieldPrev[3*ijkG1+h] = bFieldKeep(ijkG1, h);
         }
     }
     
@@ -76,6 +73,22 @@ void ClosureManager::initialize(){
     calculatePressure(CORRECTOR, -1);
 }
 
+//  driver and magnetic field kept from the previous timestep,
+//  the rest of the closure state lives on the grid
+void ClosureManager::saveState(){
+    int nG2 = (loader->resolution[0]+2)*(loader->resolution[1]+2)*(loader->resolution[2]+2);
+    int nG1 = (loader->resolution[0]+1)*(loader->resolution[1]+1)*(loader->resolution[2]+1);
+    savedDriverNext.assign(driverNext, driverNext+6*nG2);
+    savedBfieldPrev.assign(bfieldPrev, bfieldPrev+3*nG1);
+}
+
+
+void ClosureManager::restoreState(){
+    copy(savedDriverNext.begin(), savedDriverNext.end(), driverNext);
+    copy(savedBfieldPrev.begin(), savedBfieldPrev.end(), bfieldPrev);
+}
+
+
 void ClosureManager::initPressureDampingCoeff(){
 
     //needed for open boundary conditions
@@ -100,7 +113,7 @@ void ClosureManager::initPressureDampingCoeff(){
     int nG2 = xResG2*yResG2*zResG2;
     int i, j, k, idx;
     
-    pressureDampingCoeff = new double[nG2*sizeof(double)];
+    pressureDampingCoeff = new double[nG2];
     
     for( idx = 0; idx < nG2; idx++ ){
         pressureDampingCoeff[idx] = 1.0;
@@ -231,27 +244,29 @@ void ClosureManager::initPressure(){
         }
     }
     
-    gridMgr->sendBoundary2Neighbor(PRESSURE);
-    gridMgr->sendBoundary2Neighbor(PRESSURE_AUX);
+    vector<int> vars2send = {PRESSURE, PRESSURE_AUX};
+    gridMgr->sendBoundary2Neighbor(vars2send);
     
     gridMgr->applyBC(PRESSURE);
     gridMgr->applyBC(PRESSURE_AUX);
 
-    VectorVar** pdriverr = gridMgr->getVectorVariableOnG2(DRIVER);
+    FieldG2 pdriverr = gridMgr->getFieldOnG2(DRIVER);
     int nG2= xResG2*yResG2*zResG2;
-    const double* dr;
+    FieldG2 pdriveraux = gridMgr->getFieldOnG2(DRIVER_AUX);
     
     for( idxOnG2 = 0; idxOnG2 < nG2; idxOnG2++ ){
         for( h = 0; h < 6; h++ ){
-            dr = pdriverr[idxOnG2]->getValue();
-            gridMgr->setVectorVariableForNodeG2(idxOnG2, DRIVER_AUX, h, dr[h]);
-            pressuInit[6*idxOnG2+h] = dr[h];
+            pdriveraux(idxOnG2, h) = pdriverr(idxOnG2, h);
+            pressuInit[6*idxOnG2+h] = pdriverr(idxOnG2, h);
         }
     }
 }
 
 
 void ClosureManager::calculatePressure(int phase, int i_time){
+    
+    //# driver of the previous call may still be posted
+    gridMgr->flushHalos(nullptr);
 
         if( loader->useIsothermalClosure == 1 ){
 		calculateIsothermalPressure();
@@ -280,10 +295,10 @@ void ClosureManager::calculateIsothermalPressure(){
     double Tele = loader->electronTemperature;
     double dens = 0.0;
 
-    VectorVar** density  = gridMgr->getVectorVariableOnG2(DENSELEC);
+    FieldG2 density  = gridMgr->getFieldOnG2(DENSELEC);
 
     for(int ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-	dens = density[ijkG2]->getValue()[0];
+	dens = density(ijkG2, 0);
 	pressure = dens*Tele;
         gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE_SMO, 0, pressure);
 	gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE_SMO, 3, pressure);
@@ -396,45 +411,47 @@ void ClosureManager::implicitPressure(int phase, int i_time) {
     double unitB[3];
     double modulusB;
     
-    double *pPrevAll = new double[nG2*6*sizeof(double)];
+    WorkspaceScope scope(*workspace);
+    double *pPrevAll = scope.borrow<double>(nG2*6);
     
     double ts = loader->getTimeStep();
     
     string msg ="[ClosureManager] start to calculate Pressure: imlpicit scheme ";
     logger->writeMsg(msg.c_str(), DEBUG);
 
-    VectorVar** pressure    = gridMgr->getVectorVariableOnG2(PRESSURE);
-    VectorVar** pressureaux = gridMgr->getVectorVariableOnG2(PRESSURE_AUX);
-    VectorVar** pdriverr    = gridMgr->getVectorVariableOnG2(DRIVER);
+    FieldG2 pressureaux = gridMgr->getFieldOnG2(PRESSURE_AUX);
+    FieldG2 pdriverr    = gridMgr->getFieldOnG2(DRIVER);
     
-    int magField2use;
+    //# the predictor keeps its pressure in PRESSURE_AUX, the next predictor
+    //# and the corrector both start from it, no copy between the two
+    int magField2use, pressure2save;
     switch (phase){
         case PREDICTOR:
-            magField2use = MAGNETIC_AUX;
-            for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-                for( h = 0; h < 6; h++ ){
-                    pPrevAll[ijkG2*6+h] = pressureaux[ijkG2]->getValue()[h];
-                }
-            }
+            magField2use  = MAGNETIC_AUX;
+            pressure2save = PRESSURE_AUX;
             break;
         case CORRECTOR:
-            magField2use = MAGNETIC;
-            for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-                for( h = 0; h < 6; h++ ){
-                    pPrevAll[ijkG2*6+h] = pressure[ijkG2]->getValue()[h];
-                }
-            }
+            magField2use  = MAGNETIC;
+            pressure2save = PRESSURE;
             break;
         default :
             throw runtime_error("no phase");
     }
     
-    const int* neighbourhood = gridMgr->getNeighbourhoodOnG1();
-    VectorVar** bField = gridMgr->getVectorVariableOnG1(magField2use);
+    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
+        for( h = 0; h < 6; h++ ){
+            pPrevAll[ijkG2*6+h] = pressureaux(ijkG2, h);
+        }
+    }
+    
+    int strides[3], cellVertices[8];
+    gridMgr->getNodeStrides(1, 1, strides);
+    stencilOffsets(CELL_VERTICES, strides, cellVertices);
+    FieldG1 bField = gridMgr->getFieldOnG1(magField2use);
     
     int neighbour, idxNeigbor;
     
-    const double* dr;
+    double dr[6];
     double rhs;
     
     double P[3][3];
@@ -460,7 +477,7 @@ void ClosureManager::implicitPressure(int phase, int i_time) {
                 ijkG1 = IDX(i, j, k, xResG1, yResG1, zResG1);
                 
                 for( neighbour = 0; neighbour < 8; neighbour++ ){
-                    idxNeigbor = neighbourhood[8*ijkG1+neighbour];
+                    idxNeigbor = ijkG1+cellVertices[neighbour];
                     for( h = 0; h < 3; h++ ){
                         vecB[h] += 0.125*bfieldPrev[3*idxNeigbor+h];
                     }
@@ -497,7 +514,9 @@ void ClosureManager::implicitPressure(int phase, int i_time) {
                     }
                 }
                 
-                dr = pdriverr[ijkG2]->getValue();
+                for( h = 0; h < 6; h++ ){
+                    dr[h] = pdriverr(ijkG2, h);
+                }
                 h = 0;
                 for( l = 0; l < 3; l++ ){
                     for( m = l; m < 3; m++ ){
@@ -509,9 +528,9 @@ void ClosureManager::implicitPressure(int phase, int i_time) {
                 }
                 
                 for( neighbour = 0; neighbour < 8; neighbour++ ){
-                    idxNeigbor = neighbourhood[8*ijkG1+neighbour];
+                    idxNeigbor = ijkG1+cellVertices[neighbour];
                     for( h = 0; h < 3; h++ ){
-                        vecB[h] += 0.125*bField[idxNeigbor]->getValue()[h];
+                        vecB[h] += 0.125*bField(idxNeigbor, h);
                     }
                 }
                 
@@ -688,49 +707,30 @@ void ClosureManager::implicitPressure(int phase, int i_time) {
             for( k = 1; k < zRes + 1; k++ ){
                 ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
                 for( h = 0; h < 6; h++ ){
-                     gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE, h, pPrevAll[ijkG2*6+h]);
+                     gridMgr->setVectorVariableForNodeG2(ijkG2, pressure2save, h, pPrevAll[ijkG2*6+h]);
                 }
             }
         }
     }
-    delete[] pPrevAll;
     
-    gridMgr->sendBoundary2Neighbor(PRESSURE);
-    gridMgr->applyBC(PRESSURE);
+    gridMgr->sendBoundary2Neighbor(pressure2save);
+    gridMgr->applyBC(pressure2save);
     
     if( i_time % loader->smoothStride == 0 ){
-        gridMgr->smooth(PRESSURE);
-        gridMgr->applyBC(PRESSURE);
+        gridMgr->smooth(pressure2save);
+        gridMgr->applyBC(pressure2save);
     }
     
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 6; h++) {
-            gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE_SMO, h,
-                                                pressure[ijkG2]->getValue()[h]);
-        }
-    }
+    gridMgr->copyFieldOnG2(pressure2save, PRESSURE_SMO);
     
     gridMgr->smooth(PRESSURE_SMO);
     gridMgr->applyBC(PRESSURE_SMO);
     
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 6; h++ ){
-            pressuNext[6*ijkG2+h] = pressure[ijkG2]->getValue()[h];
-        }
-    }
-    
-    if( phase == PREDICTOR ) {
-        for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-            for( h = 0; h < 6; h++ ){
-                gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE_AUX, h,
-                                                    pressure[ijkG2]->getValue()[h]);
-            }
-        }
-        
-        VectorVar** bFieldKeep = gridMgr->getVectorVariableOnG1(MAGNETIC_AUX);
+    if( phase == PREDICTOR ){
+        FieldG1 bFieldKeep = gridMgr->getFieldOnG1(MAGNETIC_AUX);
         for( ijkG1 = 0; ijkG1 < nG1; ijkG1++ ){
             for( h = 0; h < 3; h++ ){
-                bfieldPrev[3*ijkG1+h] = bFieldKeep[ijkG1]->getValue()[h];
+                bfieldPrev[3*ijkG1+h] = bFieldKeep(ijkG1, h);
             }
         }
     }
@@ -740,7 +740,7 @@ void ClosureManager::implicitPressure(int phase, int i_time) {
     to_string(duration_cast<milliseconds>(end_time3 - end_time2).count())+" ms";
     logger->writeMsg(msg23.c_str(), DEBUG);
     
-    setDriver(phase);
+    setDriver(phase, pressure2save);
     
     
     auto end_time4 = high_resolution_clock::now();
@@ -789,11 +789,12 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
     double unitB[3];
     double modulusB;
     
-    double *vecBstartAll = new double[nG2*3*sizeof(double)];
-    double *vecBstepAll  = new double[nG2*3*sizeof(double)];
+    WorkspaceScope scope(*workspace);
+    double *vecBstartAll = scope.borrow<double>(nG2*3);
+    double *vecBstepAll  = scope.borrow<double>(nG2*3);
     
-    double *pSubAll      = new double[nG2*6*sizeof(double)];
-    double *iTermAll     = new double[nG2*6*sizeof(double)];;
+    double *pSubAll      = scope.borrow<double>(nG2*6);
+    double *iTermAll     = scope.borrow<double>(nG2*6);
     
     double ts = loader->getTimeStep();
     const double subDt = ts*emass;
@@ -804,62 +805,63 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
     +to_string(subDt)+" numOfSubStep = "+to_string(numOfSubStep);
     logger->writeMsg(msg.c_str(), DEBUG);
     
-    VectorVar** pressure    = gridMgr->getVectorVariableOnG2(PRESSURE);
-    VectorVar** pressure_smo = gridMgr->getVectorVariableOnG2(PRESSURE_SMO);
-    VectorVar** pressureaux = gridMgr->getVectorVariableOnG2(PRESSURE_AUX);
-    VectorVar** pdriverr    = gridMgr->getVectorVariableOnG2(DRIVER);
+    FieldG2 pressureaux = gridMgr->getFieldOnG2(PRESSURE_AUX);
+    FieldG2 pdriverr    = gridMgr->getFieldOnG2(DRIVER);
     
-    int magField2use;
+    //# the predictor keeps its pressure in PRESSURE_AUX, the next predictor
+    //# and the corrector both start from it, no copy between the two
+    int magField2use, pressure2save;
     switch (phase){
         case PREDICTOR:
-            magField2use = MAGNETIC_AUX;
-            
-            for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-                for( h = 0; h < 6; h++ ){
-                    pSubAll[ijkG2*6+h] = pressureaux[ijkG2]->getValue()[h];
-                }
-            }
+            magField2use  = MAGNETIC_AUX;
+            pressure2save = PRESSURE_AUX;
             break;
         case CORRECTOR:
-            magField2use = MAGNETIC;
-            
-            for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-                for( h = 0; h < 6; h++ ){
-                    pSubAll[ijkG2*6+h] = pressure[ijkG2]->getValue()[h];
-                }
-            }
+            magField2use  = MAGNETIC;
+            pressure2save = PRESSURE;
             break;
         default :
             throw runtime_error("no phase");
     }
     
-    const int* neighbourhood = gridMgr->getNeighbourhoodOnG1();
-    VectorVar** bField = gridMgr->getVectorVariableOnG1(magField2use);
+    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
+        for( h = 0; h < 6; h++ ){
+            pSubAll[ijkG2*6+h] = pressureaux(ijkG2, h);
+        }
+    }
+    
+    int strides[3], cellVertices[8];
+    gridMgr->getNodeStrides(1, 1, strides);
+    stencilOffsets(CELL_VERTICES, strides, cellVertices);
+    //# cell centred B is shared with Ohm's law
+    FieldG2 cellB = gridMgr->getDerivedField(magField2use == MAGNETIC
+                                             ? CELL_MAGNETIC : CELL_MAGNETIC_AUX);
     
     int neighbour, idxNeigbor;
     
     //precalculations
+    OMP(parallel for schedule(static) private(j, k, h, ijkG2, ijkG1, neighbour, idxNeigbor,
+                                              vecB, vecBnext, pSub, iTerm))
     for( i = 1; i < xRes + 1; i++ ){
         for( j = 1; j < yRes + 1; j++ ){
             for( k = 1; k < zRes + 1; k++ ){
                 
+                ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
+                
                 for( h = 0; h < 3; h++ ){
-                    vecBnext[h] = 0.0;
+                    vecBnext[h] = cellB(ijkG2, h);
                     vecB[h]     = 0.0;
                 }
                 
                 ijkG1 = IDX(i, j, k, xResG1, yResG1, zResG1);
                 
                 for( neighbour = 0; neighbour < 8; neighbour++ ){
-                    idxNeigbor = neighbourhood[8*ijkG1+neighbour];
+                    idxNeigbor = ijkG1+cellVertices[neighbour];
                     for( h = 0; h < 3; h++ ){
-                        vecBnext[h] += 0.125*bField[idxNeigbor]->getValue()[h];
-                        vecB[h]     += 0.125*bfieldPrev[3*idxNeigbor+h];
+                        vecB[h] += 0.125*bfieldPrev[3*idxNeigbor+h];
                     }
                 }
                 
-                ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
-                
                 for( h = 0; h < 3; h++ ){
                     vecBstartAll[ijkG2*3+h] = vecB[h];
                     vecBstepAll [ijkG2*3+h] = (vecBnext[h]-vecB[h])/numOfSubStep;
@@ -884,9 +886,11 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
     to_string(duration_cast<milliseconds>(end_time1 - start_time).count())+" ms";
     logger->writeMsg(msg1.c_str(), DEBUG);
     
-    const double* dr;
+    double dr[6];
     double trP, rhs;
     
+    OMP(parallel for schedule(static) private(j, k, h, m, ijkG2, pSub, dr, cTerm,
+                                              vecB, unitB, modulusB, omega, rhs, trP))
     for( i = 1; i < xRes + 1; i++ ){
         for( j = 1; j < yRes + 1; j++ ){
             for( k = 1; k < zRes + 1; k++ ){
@@ -897,7 +901,9 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
                     pSub[h] = pSubAll[ijkG2*6+h];
                 }
                 
-                dr = pdriverr[ijkG2]->getValue();
+                for( h = 0; h < 6; h++ ){
+                    dr[h] = pdriverr(ijkG2, h);
+                }
                 
                 for( m = 0; m < numOfSubStep; m++ ){
                     
@@ -1015,49 +1021,26 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
             for( k = 1; k < zRes + 1; k++ ){
                 ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
                 for (h = 0; h < 6; h++) {
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE, h, pSubAll[ijkG2*6+h]);
+                    gridMgr->setVectorVariableForNodeG2(ijkG2, pressure2save, h, pSubAll[ijkG2*6+h]);
                 }
             }
         }
     }
     
-    delete[] vecBstartAll;
-    delete[] vecBstepAll;
-    delete[] pSubAll;
-    delete[] iTermAll;
-    
-    gridMgr->sendBoundary2Neighbor(PRESSURE);
-    gridMgr->applyBC(PRESSURE);
+    gridMgr->sendBoundary2Neighbor(pressure2save);
+    gridMgr->applyBC(pressure2save);
     
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 6; h++) {
-            gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE_SMO, h,
-                                                pressure[ijkG2]->getValue()[h]);
-        }
-    }
+    gridMgr->copyFieldOnG2(pressure2save, PRESSURE_SMO);
     
     gridMgr->smooth(PRESSURE_SMO);
     gridMgr->applyBC(PRESSURE_SMO);
     
     
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 6; h++ ){
-            pressuNext[6*ijkG2+h] = pressure[ijkG2]->getValue()[h];
-        }
-    }
-    
     if( phase == PREDICTOR ){
-        for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-            for( h = 0; h < 6; h++ ){
-                gridMgr->setVectorVariableForNodeG2(ijkG2, PRESSURE_AUX, h,
-                                                    pressure[ijkG2]->getValue()[h]);
-            }
-        }
-        
-        VectorVar** bFieldKeep = gridMgr->getVectorVariableOnG1(MAGNETIC_AUX);
+        FieldG1 bFieldKeep = gridMgr->getFieldOnG1(MAGNETIC_AUX);
         for( ijkG1 = 0; ijkG1 < nG1; ijkG1++ ){
             for( h = 0; h < 3; h++ ){
-                bfieldPrev[3*ijkG1+h] = bFieldKeep[ijkG1]->getValue()[h];
+                bfieldPrev[3*ijkG1+h] = bFieldKeep(ijkG1, h);
             }
         }
     }
@@ -1067,7 +1050,7 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
     to_string(duration_cast<milliseconds>(end_time3 - end_time2).count())+" ms";
     logger->writeMsg(msg23.c_str(), DEBUG);
     
-    setDriver(phase);
+    setDriver(phase, pressure2save);
     
     
     auto end_time4 = high_resolution_clock::now();
@@ -1084,40 +1067,30 @@ void ClosureManager::subCycledPressure(int phase, int i_time) {
 
 
 
-void ClosureManager::setDriver(int phase){
+void ClosureManager::setDriver(int phase, int pressure2use){
     
     int xRes = loader->resolution[0],
         yRes = loader->resolution[1],
         zRes = loader->resolution[2];
     int xResG2 = xRes+2, yResG2 = yRes+2, zResG2 = zRes+2;
-    int nG2 = xResG2*yResG2*zResG2;
     
     int ijkG2;
     
     int i, j, k, l, m, h;
     double dTerms[3][3];
     
-    double *pDrive = new double[nG2*6*sizeof(double)];
-    
-    VectorVar** current = gridMgr->getVectorVariableOnG2(CURRENT);
-    
-    for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-        for( h = 0; h < 3; h++ ){
-            gridMgr->setVectorVariableForNodeG2(ijkG2, CURRENT_AUX, h,
-                                                current[ijkG2]->getValue()[h]);
-        }
+    if( phase != PREDICTOR && phase != CORRECTOR ){
+        throw runtime_error("no phase");
     }
     
+    gridMgr->copyFieldOnG2(CURRENT, CURRENT_AUX);
     gridMgr->smooth(CURRENT_AUX);
     gridMgr->applyBC(CURRENT_AUX);
     
-    VectorVar** current_aux = gridMgr->getVectorVariableOnG2(CURRENT_AUX);
+    FieldG2 current_aux = gridMgr->getFieldOnG2(CURRENT_AUX);
     
-    VectorVar** density  = gridMgr->getVectorVariableOnG2(DENSELEC);
-    VectorVar** velocity = gridMgr->getVectorVariableOnG2(VELOCION);
-    const double* jcur;
-    const double* edens;
-    const double* vion;
+    FieldG2 revertDensity = gridMgr->getDerivedField(REVERT_DENSITY);
+    FieldG2 velocity = gridMgr->getFieldOnG2(VELOCION);
     
     double domainShiftX = loader->boxCoordinates[0][0];
     double domainShiftY = loader->boxCoordinates[1][0];
@@ -1128,21 +1101,23 @@ void ClosureManager::setDriver(int phase){
     double dz = loader->spatialSteps[2];
     double dl[3] = {dx, dy, dz};
     
-    for( i = 0; i < xRes + 2; i++ ){
-        for (j = 0; j < yRes + 2; j++ ){
-            for (k = 0; k < zRes + 2; k++ ){
+    vector<Tile> tiles = gridMgr->getTiles(0, 2);
+    OMP(parallel for schedule(static) private(i, j, k, l, ijkG2))
+    for( int tileNum = 0; tileNum < tiles.size(); tileNum++ ){
+        const Tile& tile = tiles[tileNum];
+        for( i = tile.from[0]; i < tile.to[0]; i++ ){
+            for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                for( k = tile.from[2]; k < tile.to[2]; k++ ){
                 
-                ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
+                    ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
                 
-                jcur = current_aux[ijkG2]->getValue();
-                edens = density[ijkG2]->getValue();
-                vion = velocity[ijkG2]->getValue();
-                double revertdens = edens[0] < EPS8 ? 0.0 : edgeProfile(edens[0])/edens[0];
-                for( l = 0; l < 3; l++ ){
-                    electrnVel[3*ijkG2+l] = vion[l]-(jcur[l]*revertdens);
+                    double revertdens = revertDensity(ijkG2, 0);
+                    for( l = 0; l < 3; l++ ){
+                        electrnVel[3*ijkG2+l] = velocity(ijkG2, l)-(current_aux(ijkG2, l)*revertdens);
                     
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, VELOCELE, l,
-                                                electrnVel[3*ijkG2+l]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, VELOCELE, l,
+                                                    electrnVel[3*ijkG2+l]);
+                    }
                 }
             }
         }
@@ -1156,8 +1131,8 @@ void ClosureManager::setDriver(int phase){
     
     gradientsVelocity();
     
-    VectorVar** velDiagDer  = gridMgr->getVectorVariableOnG2(DRIVER_DIAG);
-    VectorVar** velCrossDer  = gridMgr->getVectorVariableOnG2(DRIVER_CROSS);
+    FieldG2 velDiagDer  = gridMgr->getFieldOnG2(DRIVER_DIAG);
+    FieldG2 velCrossDer  = gridMgr->getFieldOnG2(DRIVER_CROSS);
     
     int n, s;
     double divV;
@@ -1166,120 +1141,118 @@ void ClosureManager::setDriver(int phase){
     float sign;
     int diffIDX[3][2];
     
-    for( i = 1; i < xRes + 1; i++ ){
-        for( j = 1; j < yRes + 1; j++ ){
-            for( k = 1; k < zRes + 1; k++ ){
+    FieldG2 pressure = gridMgr->getFieldOnG2(pressure2use);
+    
+    //# the predictor extrapolates the driver and keeps the new terms
+    //# for the corrector, which averages them with its own ones
+    FieldG2 driver   = gridMgr->getFieldOnG2(DRIVER);
+    FieldG2 driveaux = gridMgr->getFieldOnG2(DRIVER_AUX);
+    
+    tiles = gridMgr->getTiles(1, 1);
+    OMP(parallel for schedule(static) private(i, j, k, l, m, n, s, h, ijkG2, diffIDX, sign,
+                                              upwindIDX, pe, nabP, nabV, divV, dTerms))
+    for( int tileNum = 0; tileNum < tiles.size(); tileNum++ ){
+        const Tile& tile = tiles[tileNum];
+        for( i = tile.from[0]; i < tile.to[0]; i++ ){
+            for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                for( k = tile.from[2]; k < tile.to[2]; k++ ){
                 
-                ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
+                    ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
                 
-                /* __ indices to make difference in each dir {x,y,z} __ */
-                diffIDX[0][0] = IDX(i+1, j  , k  , xResG2, yResG2, zResG2);
-                diffIDX[0][1] = IDX(i-1, j  , k  , xResG2, yResG2, zResG2);
-                diffIDX[1][0] = IDX(i  , j+1, k  , xResG2, yResG2, zResG2);
-                diffIDX[1][1] = IDX(i  , j-1, k  , xResG2, yResG2, zResG2);
-                diffIDX[2][0] = IDX(i  , j  , k+1, xResG2, yResG2, zResG2);
-                diffIDX[2][1] = IDX(i  , j  , k-1, xResG2, yResG2, zResG2);
+                    /* __ indices to make difference in each dir {x,y,z} __ */
+                    diffIDX[0][0] = IDX(i+1, j  , k  , xResG2, yResG2, zResG2);
+                    diffIDX[0][1] = IDX(i-1, j  , k  , xResG2, yResG2, zResG2);
+                    diffIDX[1][0] = IDX(i  , j+1, k  , xResG2, yResG2, zResG2);
+                    diffIDX[1][1] = IDX(i  , j-1, k  , xResG2, yResG2, zResG2);
+                    diffIDX[2][0] = IDX(i  , j  , k+1, xResG2, yResG2, zResG2);
+                    diffIDX[2][1] = IDX(i  , j  , k-1, xResG2, yResG2, zResG2);
                 
-                /* __ upwind coefficients defined by flow direction __ */
-                for( l = 0; l < 3; l++ ){//Vele{x,y,z}
-                    sign = copysignf(1, electrnVel[3*ijkG2+l]);
-                    upwindIDX[l][0] = +0.5*(1.0-sign)/dl[l]; //sign=-1 - counterflow direction use (Pi-1 - Pi)
-                    upwindIDX[l][1] =           sign /dl[l]; //center
-                    upwindIDX[l][2] = -0.5*(1.0+sign)/dl[l]; //sign=+1 - flow direction use (Pi - Pi+1)
-                }
+                    /* __ upwind coefficients defined by flow direction __ */
+                    for( l = 0; l < 3; l++ ){//Vele{x,y,z}
+                        sign = copysignf(1, electrnVel[3*ijkG2+l]);
+                        upwindIDX[l][0] = +0.5*(1.0-sign)/dl[l]; //sign=-1 - counterflow direction use (Pi-1 - Pi)
+                        upwindIDX[l][1] =           sign /dl[l]; //center
+                        upwindIDX[l][2] = -0.5*(1.0+sign)/dl[l]; //sign=+1 - flow direction use (Pi - Pi+1)
+                    }
                 
-                h = 0;
-                for( l = 0; l < 3; l++ ){
-                    for( m = l; m < 3; m++ ){
+                    h = 0;
+                    for( l = 0; l < 3; l++ ){
+                        for( m = l; m < 3; m++ ){
                         
-                        pe[l][m] = pressuNext[6*ijkG2+h];
-                        pe[m][l] = pe[l][m];
+                            pe[l][m] = pressure(ijkG2, h);
+                            pe[m][l] = pe[l][m];
                         
-                        for( s = 0; s < 3; s++ ){//d{x,y,z}  nabla P upwind scheme
-                            nabP[s][l][m] = upwindIDX[s][0]*pressuNext[6*diffIDX[s][0]+h]
-                            +upwindIDX[s][1]*pe[l][m]
-                            +upwindIDX[s][2]*pressuNext[6*diffIDX[s][1]+h];
+                            for( s = 0; s < 3; s++ ){//d{x,y,z}  nabla P upwind scheme
+                                nabP[s][l][m] = upwindIDX[s][0]*pressure(diffIDX[s][0], h)
+                                +upwindIDX[s][1]*pe[l][m]
+                                +upwindIDX[s][2]*pressure(diffIDX[s][1], h);
                             
-                            nabP[s][m][l] = nabP[s][l][m];// by Pij symmetry
+                                nabP[s][m][l] = nabP[s][l][m];// by Pij symmetry
+                            }
+                            h++;
                         }
-                        h++;
                     }
-                }
                 
-                nabV[0][0] = velDiagDer[ijkG2]->getValue()[0];
-                nabV[1][1] = velDiagDer[ijkG2]->getValue()[1];
-                nabV[2][2] = velDiagDer[ijkG2]->getValue()[2];
-                nabV[0][1] = velCrossDer[ijkG2]->getValue()[0];
-                nabV[0][2] = velCrossDer[ijkG2]->getValue()[1];
-                nabV[1][0] = velCrossDer[ijkG2]->getValue()[2];
-                nabV[1][2] = velCrossDer[ijkG2]->getValue()[3];
-                nabV[2][0] = velCrossDer[ijkG2]->getValue()[4];
-                nabV[2][1] = velCrossDer[ijkG2]->getValue()[5];
+                    nabV[0][0] = velDiagDer(ijkG2, 0);
+                    nabV[1][1] = velDiagDer(ijkG2, 1);
+                    nabV[2][2] = velDiagDer(ijkG2, 2);
+                    nabV[0][1] = velCrossDer(ijkG2, 0);
+                    nabV[0][2] = velCrossDer(ijkG2, 1);
+                    nabV[1][0] = velCrossDer(ijkG2, 2);
+                    nabV[1][2] = velCrossDer(ijkG2, 3);
+                    nabV[2][0] = velCrossDer(ijkG2, 4);
+                    nabV[2][1] = velCrossDer(ijkG2, 5);
                 
-                divV = nabV[0][0]+nabV[1][1]+nabV[2][2];
+                    divV = nabV[0][0]+nabV[1][1]+nabV[2][2];
                 
-                for( l = 0; l < 3; l++ ){
-                    for( m = l; m < 3; m++ ){
+                    for( l = 0; l < 3; l++ ){
+                        for( m = l; m < 3; m++ ){
                         
-                        /* __ P nabla . V __ */
-                        dTerms[l][m] = -pe[l][m]*divV;
+                            /* __ P nabla . V __ */
+                            dTerms[l][m] = -pe[l][m]*divV;
                         
-                        for( n = 0; n < 3; n++ ){
-                            /* __ V . nabla P __ */
-                            dTerms[l][m] -= electrnVel[3*ijkG2+n]*nabP[n][l][m];
-                            /* __ P . nabla V __ */
-                            dTerms[l][m] -= pe[l][n]*nabV[n][m];
-                            /* __ P . nabla V (transposed) __ */
-                            dTerms[l][m] -= pe[m][n]*nabV[n][l];
-                        }
-                        /* __ & set symmetrical terms __ */
-                        dTerms[m][l] = dTerms[l][m];
+                            for( n = 0; n < 3; n++ ){
+                                /* __ V . nabla P __ */
+                                dTerms[l][m] -= electrnVel[3*ijkG2+n]*nabP[n][l][m];
+                                /* __ P . nabla V __ */
+                                dTerms[l][m] -= pe[l][n]*nabV[n][m];
+                                /* __ P . nabla V (transposed) __ */
+                                dTerms[l][m] -= pe[m][n]*nabV[n][l];
+                            }
+                            /* __ & set symmetrical terms __ */
+                            dTerms[m][l] = dTerms[l][m];
 
+                        }
                     }
-                }
                 
-                h = 0;
-                for( l = 0; l < 3; l++ ){
-                    for( m = l; m < 3; m++ ){
-                        pDrive[ijkG2*6+h] = dTerms[l][m];
-                        h++;
+                    h = 0;
+                    for( l = 0; l < 3; l++ ){
+                        for( m = l; m < 3; m++ ){
+                            if( phase == PREDICTOR ){
+                                driverNext[6*ijkG2+h] = -driverNext[6*ijkG2+h]+2.0*dTerms[l][m];
+                                driveaux(ijkG2, h) = dTerms[l][m];
+                            }else{
+                                driverNext[6*ijkG2+h] = 0.5*(dTerms[l][m]+driveaux(ijkG2, h));
+                            }
+                            driver(ijkG2, h) = driverNext[6*ijkG2+h];
+                            h++;
+                        }
                     }
                 }
             }
         }
     }
     
-    VectorVar** driveaux = gridMgr->getVectorVariableOnG2(DRIVER_AUX);
-    
-    switch (phase) {
-        case PREDICTOR:
-            for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-                for (h = 0; h < 6; h++) {
-                    driverNext[6*ijkG2+h] = -driverNext[6*ijkG2+h]+2.0*pDrive[ijkG2*6+h];
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER    , h, driverNext[ijkG2*6+h]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_AUX, h, pDrive[ijkG2*6+h]);
-                }
-            }
-            gridMgr->sendBoundary2Neighbor(DRIVER_AUX);
-            gridMgr->applyBC(DRIVER_AUX);
-            
-            break;
-        case CORRECTOR:
-            for( ijkG2 = 0; ijkG2 < nG2; ijkG2++ ){
-                for( h = 0; h < 6; h++ ){
-                    driverNext[6*ijkG2+h] = 0.5*(pDrive[ijkG2*6+h]+driveaux[ijkG2]->getValue()[h]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER, h, driverNext[ijkG2*6+h]);
-                }
-            }
-            break;
-        default:
-            throw runtime_error("no phase");
+    vector<int> vars2send = {DRIVER};
+    if( phase == PREDICTOR ){
+        vars2send.push_back(DRIVER_AUX);
     }
     
-    gridMgr->sendBoundary2Neighbor(DRIVER);
-    gridMgr->applyBC(DRIVER);
-    
-    delete[] pDrive;
+    //# driver is read again by the closure of the next phase, after
+    //# particle migration, so its halo goes with the migration messages
+    for( int v = 0; v < vars2send.size(); v++ ){
+        gridMgr->postBoundary2Neighbor(vars2send[v], 0);
+    }
 }
 
     void ClosureManager::gradientsVelocity() {
@@ -1322,72 +1295,75 @@ void ClosureManager::setDriver(int phase){
         double nabV[3][3];
         int ijkG2, i, j, k, l, m, pairNum;
         
-        for( i = 1; i < xRes + 1; i++ ){
-            for( j = 1; j < yRes + 1; j++ ){
-                for( k = 1; k < zRes + 1; k++ ){
+        vector<Tile> tiles = gridMgr->getTiles(1, 1);
+        OMP(parallel for schedule(static) private(i, j, k, l, m, pairNum, ijkG2,
+                                                  idxRight, idxLeft, nabV))
+        for( int tileNum = 0; tileNum < tiles.size(); tileNum++ ){
+            const Tile& tile = tiles[tileNum];
+            for( i = tile.from[0]; i < tile.to[0]; i++ ){
+                for( j = tile.from[1]; j < tile.to[1]; j++ ){
+                    for( k = tile.from[2]; k < tile.to[2]; k++ ){
                     
-                    ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
+                        ijkG2 = IDX(i, j, k, xResG2, yResG2, zResG2);
                     
-                    /* __  nabla V centered in space __ */
-                    for( l = 0; l < 3; l++ ){//d{x,y,z}
-                        for( m = 0; m < 3; m++ ){//Vele{x,y,z}
+                        /* __  nabla V centered in space __ */
+                        for( l = 0; l < 3; l++ ){//d{x,y,z}
+                            for( m = 0; m < 3; m++ ){//Vele{x,y,z}
                             
-                            idxRight = IDX(i+zeroOrderNeighb[2*l+1][0],
-                                           j+zeroOrderNeighb[2*l+1][1],
-                                           k+zeroOrderNeighb[2*l+1][2],
-                                           xResG2,yResG2,zResG2);
+                                idxRight = IDX(i+zeroOrderNeighb[2*l+1][0],
+                                               j+zeroOrderNeighb[2*l+1][1],
+                                               k+zeroOrderNeighb[2*l+1][2],
+                                               xResG2,yResG2,zResG2);
                             
-                            idxLeft =  IDX(i+zeroOrderNeighb[2*l+0][0],
-                                           j+zeroOrderNeighb[2*l+0][1],
-                                           k+zeroOrderNeighb[2*l+0][2],
-                                           xResG2,yResG2,zResG2);
+                                idxLeft =  IDX(i+zeroOrderNeighb[2*l+0][0],
+                                               j+zeroOrderNeighb[2*l+0][1],
+                                               k+zeroOrderNeighb[2*l+0][2],
+                                               xResG2,yResG2,zResG2);
                             
-                            nabV[l][m] = k1*(electrnVel[3*idxRight+m] - electrnVel[3*idxLeft+m]);
+                                nabV[l][m] = k1*(electrnVel[3*idxRight+m] - electrnVel[3*idxLeft+m]);
                             
-                            for( pairNum = 0; pairNum < 4; pairNum++ ){
-                                idxRight = IDX(i+firstOrderNeighb[8*l+2*pairNum+1][0],
-                                               j+firstOrderNeighb[8*l+2*pairNum+1][1],
-                                               k+firstOrderNeighb[8*l+2*pairNum+1][2],
-                                               xResG2,yResG2,zResG2);
+                                for( pairNum = 0; pairNum < 4; pairNum++ ){
+                                    idxRight = IDX(i+firstOrderNeighb[8*l+2*pairNum+1][0],
+                                                   j+firstOrderNeighb[8*l+2*pairNum+1][1],
+                                                   k+firstOrderNeighb[8*l+2*pairNum+1][2],
+                                                   xResG2,yResG2,zResG2);
                                 
-                                idxLeft  = IDX(i+firstOrderNeighb[8*l+2*pairNum+0][0],
-                                               j+firstOrderNeighb[8*l+2*pairNum+0][1],
-                                               k+firstOrderNeighb[8*l+2*pairNum+0][2],
-                                               xResG2,yResG2,zResG2);
-                                // have to keep second order because of hedp applications
-                                // where too hot plasma oscillations lead to cross derivatives (dxVy, dyVx, ...) overestimation
-                                // and negative temperature as result
-                                nabV[l][m] += k2*(electrnVel[3*idxRight+m] - electrnVel[3*idxLeft+m]);
+                                    idxLeft  = IDX(i+firstOrderNeighb[8*l+2*pairNum+0][0],
+                                                   j+firstOrderNeighb[8*l+2*pairNum+0][1],
+                                                   k+firstOrderNeighb[8*l+2*pairNum+0][2],
+                                                   xResG2,yResG2,zResG2);
+                                    // have to keep second order because of hedp applications
+                                    // where too hot plasma oscillations lead to cross derivatives (dxVy, dyVx, ...) overestimation
+                                    // and negative temperature as result
+                                    nabV[l][m] += k2*(electrnVel[3*idxRight+m] - electrnVel[3*idxLeft+m]);
+                                }
+                                nabV[l][m] = nabV[l][m]/dl[l];
                             }
-                            nabV[l][m] = nabV[l][m]/dl[l];
                         }
-                    }
                     
                     
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_DIAG, 0, nabV[0][0]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_DIAG, 1, nabV[1][1]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_DIAG, 2, nabV[2][2]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_DIAG, 0, nabV[0][0]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_DIAG, 1, nabV[1][1]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_DIAG, 2, nabV[2][2]);
                     
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 0, nabV[0][1]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 1, nabV[0][2]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 2, nabV[1][0]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 3, nabV[1][2]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 4, nabV[2][0]);
-                    gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 5, nabV[2][1]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 0, nabV[0][1]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 1, nabV[0][2]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 2, nabV[1][0]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 3, nabV[1][2]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 4, nabV[2][0]);
+                        gridMgr->setVectorVariableForNodeG2(ijkG2, DRIVER_CROSS, 5, nabV[2][1]);
+                    }
                 }
             }
         }
         
-        gridMgr->sendBoundary2Neighbor(DRIVER_DIAG);
+        vector<int> vars2send = {DRIVER_DIAG, DRIVER_CROSS};
+        gridMgr->sendBoundary2Neighbor(vars2send);
         gridMgr->applyBC(DRIVER_DIAG);
-        
-        gridMgr->smooth(DRIVER_DIAG);
-        gridMgr->applyBC(DRIVER_DIAG);
-        
-        gridMgr->sendBoundary2Neighbor(DRIVER_CROSS);
         gridMgr->applyBC(DRIVER_CROSS);
         
-        gridMgr->smooth(DRIVER_CROSS);
+        gridMgr->smooth(vars2send);
+        gridMgr->applyBC(DRIVER_DIAG);
         gridMgr->applyBC(DRIVER_CROSS);
         
     }
@@ -9,6 +9,7 @@
 #include <cmath>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "../../grid/GridManager.hpp"
 #include "../../input/Loader.hpp"
@@ -20,16 +21,20 @@ private:
     std::unique_ptr<Logger> logger;
     std::shared_ptr<Loader> loader;
     std::shared_ptr<GridManager> gridMgr;
+    std::shared_ptr<Workspace> workspace;
     
     double emass = 0.01;
     
     double* driverNext;
-    double* pressuNext;
     double* electrnVel;
     double* bfieldPrev;
     double* pressuInit;
     double* pressureDampingCoeff;
     
+    //# driver and magnetic field history at the start of the timestep
+    std::vector<double> savedDriverNext;
+    std::vector<double> savedBfieldPrev;
+    
     void initialize();
     void initPressure();
     void initPressureDampingCoeff();
@@ -37,7 +42,7 @@ private:
     void subCycledPressure(int, int);
     void implicitPressure(int, int);
     
-    void setDriver(int );
+    void setDriver(int, int);
     void setIsotropization(double[6], double[6]);
     
     void gradientsVelocity();
@@ -48,9 +53,12 @@ private:
     void calculateIsothermalPressure();
 
 public:
-    ClosureManager(std::shared_ptr<Loader>, std::shared_ptr<GridManager>);
+    ClosureManager(std::shared_ptr<Loader>, std::shared_ptr<GridManager>,
+                   std::shared_ptr<Workspace>);
     ~ClosureManager();
     void calculatePressure(int, int);
+    void saveState();
+    void restoreState();
 
 };
 
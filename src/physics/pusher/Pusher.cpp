@@ -6,8 +6,10 @@ using namespace chrono;
 
 Pusher::Pusher(shared_ptr<Loader> ldr,
                shared_ptr<GridManager> gridMnr,
-               shared_ptr<BoundaryManager> boundMnr):loader(move(ldr)),
-                gridMgr(move(gridMnr)), boundaryMgr(move(boundMnr)){
+               shared_ptr<BoundaryManager> boundMnr,
+               shared_ptr<Workspace> wrkspc):loader(move(ldr)),
+                gridMgr(move(gridMnr)), boundaryMgr(move(boundMnr)),
+                workspace(move(wrkspc)){
     
     logger.reset(new Logger());
     initialize();
@@ -238,13 +240,92 @@ vector<shared_ptr<Particle>> Pusher::getLeftParticles(){
     return leftParticles;
 }
 
-void Pusher::push(int phase, int i_time){
+
+//  max of |v|/dx over the moving particles of all domains and resolved axes,
+//  a timestep of CFL number c is c over that
+double Pusher::getCourantRate(){
     
-   logger->writeMsg(("[Pusher] start pushing "+to_string(currentPartclNumOnDomain)
-                                    +" particles...").c_str(), DEBUG);
+    double localMax = 0.0, globalMax = 0.0;
+    double* prtclVel;
+    int coord;
     
+    for( int idx = 0; idx < currentPartclNumOnDomain; idx++ ){
+        if( iffrozens[particles[idx]->getType()] == 1 ){
+            continue;
+        }
+        prtclVel = particles[idx]->getVelocity();
+        for( coord = 0; coord < 3; coord++ ){
+            if( loader->totPixelsPerBoxSide[coord] > 1 ){
+                localMax = max(localMax, abs(prtclVel[coord])/loader->spatialSteps[coord]);
+            }
+        }
+    }
     
-    auto start_time = high_resolution_clock::now();
+    MPI_Allreduce(&localMax, &globalMax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return globalMax;
+}
+
+
+//  max gyrofrequency |q/m||B| of the moving species over the nodes of all domains
+double Pusher::getGyroRate(){
+    
+    int xSize = loader->resolution[0];
+    int ySize = loader->resolution[1];
+    int zSize = loader->resolution[2];
+    
+    double qmMax = 0.0;
+    for( int spn = 0; spn < loader->getNumberOfSpecies(); spn++ ){
+        if( iffrozens[spn] == 0 && masses[spn] > 0.0 ){
+            qmMax = max(qmMax, abs(charges[spn]/masses[spn]));
+        }
+    }
+    
+    FieldG1 bField = gridMgr->getFieldOnG1(MAGNETIC);
+    const double* Bx = bField.getComponent(0);
+    const double* By = bField.getComponent(1);
+    const double* Bz = bField.getComponent(2);
+    
+    double localMax = 0.0, globalMax = 0.0;
+    int i, j, k, idxG1;
+    
+    for( i = 1; i < xSize+1; i++ ){
+        for( j = 1; j < ySize+1; j++ ){
+            for( k = 1; k < zSize+1; k++ ){
+                idxG1 = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
+                localMax = max(localMax, Bx[idxG1]*Bx[idxG1]+By[idxG1]*By[idxG1]+Bz[idxG1]*Bz[idxG1]);
+            }
+        }
+    }
+    
+    MPI_Allreduce(&localMax, &globalMax, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    return qmMax*sqrt(globalMax);
+}
+
+
+//  copy of the particles on the domain, leaving particles are only counted:
+//  the ones recorded by a rejected timestep are dropped on restore
+void Pusher::saveState(){
+    savedParticles.resize(PARTICLES_SIZE*currentPartclNumOnDomain);
+    for( int idx = 0; idx < currentPartclNumOnDomain; idx++ ){
+        particles[idx]->serialize(savedParticles.data(), PARTICLES_SIZE*idx);
+    }
+    savedLeftParticlesNum = leftParticles.size();
+}
+
+
+void Pusher::restoreState(){
+    //# the particle array is only grown, so the saved ones fit
+    currentPartclNumOnDomain = savedParticles.size()/PARTICLES_SIZE;
+    for( int idx = 0; idx < currentPartclNumOnDomain; idx++ ){
+        particles[idx]->deserialize(savedParticles.data(), PARTICLES_SIZE*idx);
+    }
+    leftParticles.resize(savedLeftParticlesNum);
+}
+
+//  particle loop for a run of DIM dimensions: positions change along
+//  the first DIM axes, domain of leaving particles is found along them
+template<int DIM>
+void Pusher::pushParticles(int phase){
     
     double E[3], B[3];
     
@@ -286,8 +367,8 @@ void Pusher::push(int phase, int i_time){
 
     int type;
   
-    VectorVar** Efield   = gridMgr->getVectorVariableOnG2(ELECTRIC);
-    VectorVar** Bfield   = gridMgr->getVectorVariableOnG1(MAGNETIC);
+    FieldG2 Efield   = gridMgr->getFieldOnG2(ELECTRIC);
+    FieldG1 Bfield   = gridMgr->getFieldOnG1(MAGNETIC);
     
     int G2nodesNumber = (xSize+2)*(ySize+2)*(zSize+2);
     int G1nodesNumber = (xSize+1)*(ySize+1)*(zSize+1);
@@ -417,11 +498,9 @@ void Pusher::push(int phase, int i_time){
             gamma = gammasE[neigh_num];
             weightE = alpha*betta*gamma;
  
-            const double* ef = Efield[idxG2]->getValue();
-            const double* bf = Bfield[idxG1]->getValue();
             for( int coord = 0; coord < 3; coord++ ){
-                E[coord] += weightE*ef[coord];
-                B[coord] += weightB*bf[coord];
+                E[coord] += weightE*Efield(idxG2, coord);
+                B[coord] += weightB*Bfield(idxG1, coord);
             }
         }
         
@@ -460,21 +539,44 @@ void Pusher::push(int phase, int i_time){
             particles[idx]->setVelocity(velShift+coord, new_velocity[coord]);
         }
         // # change coordinates only in corresponding directions (1D - X, 2D - X/Y, 3D X/Y/Z)
-        for( coord=0; coord < loader->dim; coord++ ){
+        for( coord=0; coord < DIM; coord++ ){
             new_position[coord] = prtclPos[coord+posShift] + new_velocity[coord]*ts;
             particles[idx]->setPosition(posShift+coord, new_position[coord]);
         }
 
-        int domainNum = boundaryMgr->isPtclOutOfDomain(new_position);
+        int domainNum = boundaryMgr->isPtclOutOfDomain<DIM>(new_position);
         if( domainNum != IN ){
             prtclPos = particles[idx]->getPosition();
             double _pos[3] = {prtclPos[posShift+0],prtclPos[posShift+1],prtclPos[posShift+2]};
-            boundaryMgr->storeParticle(idx, _pos);
+            boundaryMgr->storeParticle<DIM>(idx, _pos);
         }
         
     }
+}
+
+
+void Pusher::push(int phase, int i_time){
+    
+   logger->writeMsg(("[Pusher] start pushing "+to_string(currentPartclNumOnDomain)
+                                    +" particles...").c_str(), DEBUG);
     
     
+    auto start_time = high_resolution_clock::now();
+    
+    switch (loader->dim) {
+        case 1:
+            pushParticles<1>(phase);
+            break;
+        case 2:
+            pushParticles<2>(phase);
+            break;
+        case 3:
+            pushParticles<3>(phase);
+            break;
+        default:
+            throw runtime_error("dimension is not 1/2/3");
+    }
+    
     auto end_time = high_resolution_clock::now();
     string msgs ="[Pusher] solve(): before applying BC duration = "
                     +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
@@ -610,8 +712,13 @@ void Pusher::performSorting(){
     int zSize = loader->resolution[2];
     int G2nodesNumber = (xSize+2)*(ySize+2)*(zSize+2);
     
-    int *df = new int[G2nodesNumber];
-    int *indecies = new int[currentPartclNumOnDomain];
+    if( cellOrder.empty() ){
+        cellOrder = gridMgr->getNodeOrder(2, loader->particleOrdering);
+    }
+    
+    WorkspaceScope scope(*workspace);
+    int *df = scope.borrow<int>(G2nodesNumber);
+    int *indecies = scope.borrow<int>(currentPartclNumOnDomain);
     
     for( int ijk = 0; ijk < G2nodesNumber; ijk++ ){
             df[ijk] = 0;
@@ -635,7 +742,7 @@ void Pusher::performSorting(){
         j = (int)floor(y);
         k = (int)floor(z);
         
-        idxCurrent = IDX(i ,j ,k, xSize+2, ySize+2, zSize+2);
+        idxCurrent = cellOrder[IDX(i ,j ,k, xSize+2, ySize+2, zSize+2)];
         indecies[idx] = idxCurrent;
         
         df[idxCurrent]++;
@@ -649,27 +756,18 @@ void Pusher::performSorting(){
         sum += cur;
     }
     
-    vector<shared_ptr<Particle>> particlesTemp;
-    particlesTemp.reserve(currentPartclNumOnDomain);
-    
-    for( int idx = 0; idx < currentPartclNumOnDomain; idx++ ){
-        particlesTemp.push_back(shared_ptr<Particle>(new Particle));
-    }
+    //# particles in the new order are serialized into the workspace
+    double* particlesTemp = scope.borrow<double>(PARTICLES_SIZE*currentPartclNumOnDomain);
     
     for( int idx = 0; idx < currentPartclNumOnDomain; idx++ ){
         newidx = df[indecies[idx]]++;
-        particlesTemp[newidx]->reinitializeUsingParticle(particles[idx]);
+        particles[idx]->serialize(particlesTemp, PARTICLES_SIZE*newidx);
     }
     
     for( int idx = 0; idx < currentPartclNumOnDomain; idx++ ){
-        particles[idx]->reinitializeUsingParticle(particlesTemp[idx]);
+        particles[idx]->deserialize(particlesTemp, PARTICLES_SIZE*idx);
     }
     
-    particlesTemp.clear();
-    
-    delete[] df;
-    delete[] indecies;
-    
     auto end_time = high_resolution_clock::now();
     string msg ="[Pusher] sorting...DONE: duration = "
     +to_string(duration_cast<milliseconds>(end_time - start_time).count())+" ms";
@@ -706,10 +804,10 @@ void Pusher::checkEnergyBalance(int i_time){
     
     int numOfSpecies = loader->getNumberOfSpecies();
     
-    map<int, VectorVar**> dens_vel;
+    map<int, FieldG2> dens_vel;
     
     for( int spn = 0; spn < numOfSpecies; spn++ ){
-        dens_vel[spn] = gridMgr->getVectorVariableOnG2(gridMgr->DENS_VEL(spn));
+        dens_vel[spn] = gridMgr->getFieldOnG2(gridMgr->DENS_VEL(spn));
     }
     
     double* prtclPos;
@@ -768,14 +866,14 @@ void Pusher::checkEnergyBalance(int i_time){
             idx_z = k + neighbourhood[neigh_num][2];
             
             idxG2 = IDX(idx_x ,idx_y ,idx_z, xSizeG2, ySizeG2, zSizeG2);
-            const double* fluidvel = dens_vel[type][idxG2]->getValue();
+            FieldG2 fluidvel = dens_vel[type];
             
             alpha = alphas[neigh_num];
             betta = bettas[neigh_num];
             gamma = gammas[neigh_num];
             
             for( int coord = 0; coord < 3; coord++ ){
-                double vel = alpha*betta*gamma*fluidvel[coord+1];
+                double vel = alpha*betta*gamma*fluidvel(idxG2, coord+1);
                 ionEnergy += (0.5*vel*vel);
             }
         }
@@ -784,32 +882,25 @@ void Pusher::checkEnergyBalance(int i_time){
     
     
     
-    VectorVar** pressure = gridMgr->getVectorVariableOnG2(PRESSURE);
-    const double* pres;
+    FieldG2 pressure = gridMgr->getFieldOnG2(PRESSURE);
     double electronEnergy = 0;
     for( int ijkG2 = 0; ijkG2 < G2nodesNumber; ijkG2++ ){
-        pres = pressure[ijkG2]->getValue();
-        double trP = (pres[0]+pres[3]+pres[5])/3;
+        double trP = (pressure(ijkG2, 0)+pressure(ijkG2, 3)+pressure(ijkG2, 5))/3;
         electronEnergy += trP;
     }
     
     
     
-    double locB[3];
-    VectorVar** bField   = gridMgr->getVectorVariableOnG1(MAGNETIC);
+    //# B in the cells of the domain, shared with the closure and Ohm's law
+    FieldG2 cellB = gridMgr->getDerivedField(CELL_MAGNETIC);
     double magneticEnergy = 0;
-    const int* neighbourhoodG1 = gridMgr->getNeighbourhoodOnG1();
-    int idxNeigbor, coord, neighbour, idxG1 ;
-    for ( i=0; i<xSize; i++){
-        for ( j=0; j<ySize; j++){
-            for ( k=0; k<zSize; k++){
-                idxG1 = IDX(i,j,k,xSize+1,ySize+1,zSize+1);
+    int coord, idxG2;
+    for ( i=1; i<xSize+1; i++){
+        for ( j=1; j<ySize+1; j++){
+            for ( k=1; k<zSize+1; k++){
+                idxG2 = IDX(i,j,k,xSizeG2,ySizeG2,zSizeG2);
                 for (coord=0; coord<3; coord++){
-                    for ( neighbour = 0; neighbour < 8; neighbour++ ){
-                        idxNeigbor = neighbourhoodG1[8*idxG1+neighbour];
-                        locB[coord] += 0.125*bField[idxNeigbor]->getValue()[coord];
-                    }
-                    magneticEnergy += 0.5*locB[coord]*locB[coord];
+                    magneticEnergy += 0.5*cellB(idxG2, coord)*cellB(idxG2, coord);
                 }
 
             }
@@ -26,6 +26,7 @@ private:
     std::shared_ptr<Loader> loader;
     std::shared_ptr<GridManager> gridMgr;
     std::shared_ptr<BoundaryManager> boundaryMgr;
+    std::shared_ptr<Workspace> workspace;
     
     double* weights;
     double* charges;
@@ -40,6 +41,14 @@ private:
     int currentPartclNumOnDomain = 0;
     Particle** particles;    
     std::vector<std::shared_ptr<Particle>> leftParticles;
+    
+    //# sorting key of particles in a cell on G2: position of the cell
+    //# in the ordering set in the input file
+    std::vector<int> cellOrder;
+    
+    //# particles at the start of the timestep, to roll a rejected one back
+    std::vector<double> savedParticles;
+    int savedLeftParticlesNum = 0;
        
     void initialize();
     
@@ -47,12 +56,16 @@ private:
     
     void performSorting();
     
+    template<int DIM>
+    void pushParticles(int);
+    
     void reallocateParticles(int);
     
 public:
     Pusher(std::shared_ptr<Loader>,
            std::shared_ptr<GridManager>,
-           std::shared_ptr<BoundaryManager>);
+           std::shared_ptr<BoundaryManager>,
+           std::shared_ptr<Workspace>);
     
     ~Pusher();
     void push(int, int);
@@ -78,6 +91,11 @@ public:
     
     void checkEnergyBalance(int);
     
+    double getCourantRate();
+    double getGyroRate();
+    void saveState();
+    void restoreState();
+    
     Particle** getParticles();
     std::vector<std::shared_ptr<Particle>> getLeftParticles();
     
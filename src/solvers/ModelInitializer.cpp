@@ -109,8 +109,8 @@ void ModelInitializer::readAllFromFile(){
     hsize_t locOffset = g2offset[rank];
     
     for ( int varN = 0; varN < totVarsOnG2; varN++ ){
-        VectorVar** vars = gridMng->getVectorVariableOnG2(varN);
-        int varSize = vars[0]->getSize();
+        FieldG2 vars = gridMng->getFieldOnG2(varN);
+        int varSize = vars.getSize();
         
         double* field = new double[g2nodes[rank]];
          for ( int dir = 0; dir < varSize; dir++ ){
@@ -138,8 +138,8 @@ void ModelInitializer::readAllFromFile(){
     int totVarsOnG1 = gridMng->getVarsNumOnG1();
     
     for ( int varN=0; varN<totVarsOnG1; varN++){
-        VectorVar** vars = gridMng->getVectorVariableOnG1(varN);
-        int varSize = vars[0]->getSize();
+        FieldG1 vars = gridMng->getFieldOnG1(varN);
+        int varSize = vars.getSize();
         
         double* field = new double[g1nodes[rank]];
         for ( int dir=0; dir<varSize; dir++){
@@ -469,7 +469,7 @@ void ModelInitializer::initParticles(){
     
     logger->writeMsg(msg001a1.c_str(),  DEBUG);
     
-    map<int, VectorVar**> dens;
+    map<int, FieldG2> dens;
     
     for( spn = 0; spn < numOfSpecies; spn++ ){
         
@@ -487,7 +487,7 @@ void ModelInitializer::initParticles(){
         }
         
         pusher->setParticleWeight4Type(spn, prtcleWeight[spn]);
-        dens[spn] = gridMng->getVectorVariableOnG2(gridMng->DENS_VEL(spn));
+        dens[spn] = gridMng->getFieldOnG2(gridMng->DENS_VEL(spn));
     }
     
    
@@ -508,7 +508,7 @@ void ModelInitializer::initParticles(){
                 
                 for( spn = 0; spn < numOfSpecies; spn++ ){
                     
-                    requiredPrtclNum = int(dens[spn][idxOnG2]->getValue()[0]/
+                    requiredPrtclNum = int(dens[spn](idxOnG2, 0)/
                                            pusher->getParticleWeight4Type(spn));
                     
                     
@@ -28,68 +28,299 @@ Solver::Solver(shared_ptr<Loader> load,
 
 void Solver::initialize()
 {
+    buildPhaseGraph(PREDICTOR);
+    buildPhaseGraph(CORRECTOR);
+    
+    //# stages without communication run on worker threads next to the
+    //# ones calling MPI, which stay on the main thread
+    int provided;
+    MPI_Query_thread(&provided);
+    phaseGraphs[PREDICTOR].setWorkers(provided >= MPI_THREAD_FUNNELED);
+    phaseGraphs[CORRECTOR].setWorkers(provided >= MPI_THREAD_FUNNELED);
+    
+    logger->writeMsg(phaseGraphs[PREDICTOR].toDot("PREDICTOR").c_str(), DEBUG);
+    logger->writeMsg(phaseGraphs[CORRECTOR].toDot("CORRECTOR").c_str(), DEBUG);
     logger->writeMsg("[Solver] initialize...OK", DEBUG);
 }
 
 
+//  stages of a phase with the data they read and write: particles, E, B,
+//  current J, ion moments, electron pressure Pe and its driver.
+//  Halos posted by a stage (J of Jnext, driver of the closure) are
+//  completed by the next particle migration or flush, which write them
+void Solver::buildPhaseGraph(int PHASE){
+    
+    TaskGraph& graph = phaseGraphs[PHASE];
+    
+    //# B advanced by the half step: predicted one in the predictor
+    string Bhalf = PHASE == PREDICTOR ? "B_aux" : "B";
+    
+    //# sub-steps of B take J and E of Ohm's law as scratch and exchange
+    //# their halos, a single step is local to the domain
+    int subcycled = loader->maxFieldSubcycles > 1;
+    vector<string> readsBhalf  = {"B", "E"};
+    vector<string> writesBhalf = {Bhalf};
+    if( subcycled ){
+        readsBhalf.push_back("moments");
+        readsBhalf.push_back("Pe");
+        writesBhalf.push_back("J");
+        writesBhalf.push_back("E");
+    }
+    
+    if( loader->getCollisionFrequencyFactor() > 0.0 ){
+        graph.addTask("collideIons", {"particles", "moments"}, {"particles"}, 0,
+                      [this, PHASE](){ collideMng->collideIons(PHASE); });
+    }
+    
+    graph.addTask("push", {"particles", "E", "B"}, {"particles", "J", "driver"}, 1,
+                  [this, PHASE](){ pusher->push(PHASE, currentStep); });
+    
+    //# halos posted before the push went with the migrating particles,
+    //# unless no particles were exchanged
+    graph.addTask("flushHalos", {}, {"J", "driver"}, 1,
+                  [this](){ gridMng->flushHalos(nullptr); });
+    
+    if( loader->numOfSpots > 0 ){
+        graph.addTask("addIons", {"moments"}, {"particles"}, 0,
+                      [this](){ laserMng->addIons(simulationTime); });
+    }
+    
+    graph.addTask("gatherMoments", {"particles"}, {"moments"}, 1,
+                  [this, PHASE](){ hydroMng->gatherMoments(PHASE); });
+    
+    graph.addTask("calculateBhalf", readsBhalf, writesBhalf, subcycled,
+                  [this, PHASE](){ emMng->calculateBhalf(PHASE); });
+    
+    graph.addTask("calculateJhalf", {"B"}, {"J"}, 1,
+                  [this, PHASE](){ emMng->calculateJhalf(PHASE); });
+    
+    graph.addTask("calculatePressure", {"Pe", "driver", "moments", "J", "B", "B_aux"},
+                  {"Pe", "driver"}, 1,
+                  [this, PHASE](){ closureMng->calculatePressure(PHASE, currentStep); });
+    
+    if( loader->numOfSpots > 0 ){
+        graph.addTask("accelerate", {"driver"}, {"driver"}, 1,
+                      [this](){ laserMng->accelerate(simulationTime); });
+    }
+    
+    graph.addTask("calculateEnext", {Bhalf, "E", "J", "moments", "Pe"}, {"E"}, 1,
+                  [this, PHASE](){ emMng->calculateEnext(PHASE); });
+    
+    vector<string> readsBnext  = {"B_aux", "E"};
+    vector<string> writesBnext = {"B"};
+    if( subcycled ){
+        readsBnext.push_back("moments");
+        readsBnext.push_back("Pe");
+        writesBnext.push_back("J");
+        writesBnext.push_back("E");
+    }
+    graph.addTask("calculateBnext", readsBnext, writesBnext, subcycled,
+                  [this](){ emMng->calculateBnext(); });
+    
+    graph.addTask("calculateJnext", {"B"}, {"J"}, 1,
+                  [this](){ emMng->calculateJnext(); });
+}
+
+
 int Solver::solve(int i_time)
 {
     int rank ;
     MPI_Comm_rank(MPI_COMM_WORLD, &rank);
     
-    try{
-        performCalculation(PREDICTOR, i_time);
-        performCalculation(CORRECTOR, i_time);
-        
-    }catch(...){
-        return SOLVE_FAIL;
+    double time = simulationTime;
+    
+    if( loader->adaptiveTimeStep ){
+        if( solveAdaptive(i_time) == SOLVE_FAIL ){
+            return SOLVE_FAIL;
+        }
+    }else{
+        try{
+            performCalculation(PREDICTOR, i_time);
+            performCalculation(CORRECTOR, i_time);
+            
+        }catch(...){
+            return SOLVE_FAIL;
+        }
+        simulationTime = (i_time+1)*loader->getTimeStep();
     }
 
     if (rank == 0){
-        double ts = loader->getTimeStep();
         string msg ="[Solver] SOLVER step ="
-                        +to_string(i_time)+"; time = "+to_string(i_time*ts);
+                        +to_string(i_time)+"; time = "+to_string(time);
         logger->writeMsg(msg.c_str(), DEBUG);
     }
     
     return SOLVE_OK;
 }
 
-void Solver::performCalculation(int PHASE, int i_time){
-    logger->writeMsg("[Solver] in performCalculation()...", DEBUG);
+
+//  timestep of at most the stable one, grown after steps without clamping.
+//  While the corrector's electric field is clamped at more than
+//  maxClampedFraction of the nodes the step is rolled back and retried
+//  with a shorter one, down to minTimeStep. A failure raised on one domain is not rolled back:
+//  the other domains may wait for it in a collective
+int Solver::solveAdaptive(int i_time){
     
-    if( loader->getCollisionFrequencyFactor() > 0.0 ){
-        collideMng->collideIons(PHASE);  
+    int rank ;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    
+    double ts = min(loader->getTimeStep(), getStableTimeStep());
+    ts = min(max(ts, loader->minTimeStep), loader->maxTimeStep);
+    loader->setTimeStep(ts);
+    
+    double nodesNum = (double) loader->totPixelsPerBoxSide[0]
+                     *loader->totPixelsPerBoxSide[1]*loader->totPixelsPerBoxSide[2];
+    long clampedLimit = (long) (loader->maxClampedFraction*nodesNum);
+    long clamped, totClamped;
+    
+    saveState();
+    
+    while( true ){
+        try{
+            performCalculation(PREDICTOR, i_time);
+            performCalculation(CORRECTOR, i_time);
+            
+        }catch(...){
+            return SOLVE_FAIL;
+        }
+        clamped = emMng->getCorrectorClampedNodesNum();
+        MPI_Allreduce(&clamped, &totClamped, 1, MPI_LONG, MPI_SUM, MPI_COMM_WORLD);
+        
+        if( totClamped <= clampedLimit || ts <= loader->minTimeStep ){
+            break;
+        }
+        
+        restoreState();
+        rejectedSteps++;
+        ts = max(TIMESTEP_CUT*ts, loader->minTimeStep);
+        loader->setTimeStep(ts);
+        
+        if( rank == 0 ){
+            string msg = "[Solver] step "+to_string(i_time)+" rejected: E clamped at "
+                        +to_string(totClamped)+" nodes, retry with timeStep = "+to_string(ts);
+            logger->writeMsg(msg.c_str(), INFO);
+        }
     }
-
-    pusher->push(PHASE, i_time);
     
-    if( loader->numOfSpots > 0 ){
-        laserMng->addIons(i_time);
+    if( totClamped > clampedLimit && rank == 0 ){
+        string msg = "[Solver] step "+to_string(i_time)+" accepted at min timeStep with E clamped at "
+                    +to_string(totClamped)+" nodes";
+        logger->writeMsg(msg.c_str(), CRITICAL);
+    }
+    
+    simulationTime += ts;
+    if( minUsedTimeStep == 0.0 ){
+        minUsedTimeStep = ts;
+        maxUsedTimeStep = ts;
+    }
+    minUsedTimeStep = min(minUsedTimeStep, ts);
+    maxUsedTimeStep = max(maxUsedTimeStep, ts);
+    
+    //# the stable limit of the grown step is checked at the start of the next one
+    if( totClamped == 0 ){
+        loader->setTimeStep(min(TIMESTEP_GROWTH*ts, loader->maxTimeStep));
     }
     
-    hydroMng->gatherMoments(PHASE);
+    return SOLVE_OK;
+}
+
 
-    emMng->calculateBhalf(PHASE);
-    emMng->calculateJhalf(PHASE);
+//  largest timestep keeping the fastest particle, the finest grid whistler
+//  per sub-step of the magnetic field and the fastest gyration within
+//  courantNumber of their stability limits
+double Solver::getStableTimeStep(){
     
-    closureMng->calculatePressure(PHASE, i_time);
+    double rates[3] = {pusher->getCourantRate(),
+                       emMng->getWhistlerRate()/loader->maxFieldSubcycles,
+                       pusher->getGyroRate()};
     
-    if( loader->numOfSpots > 0 ){
-        laserMng->accelerate(i_time);
+    double ts = loader->maxTimeStep;
+    for( int n = 0; n < 3; n++ ){
+        if( rates[n] > 0.0 ){
+            ts = min(ts, loader->courantNumber/rates[n]);
+        }
     }
     
-    emMng->calculateEnext(PHASE);
+    string msg = "[Solver] stable timeStep = "+to_string(ts)
+                +"; CFL rate = "+to_string(rates[0])
+                +"; whistler rate = "+to_string(rates[1])
+                +"; gyro rate = "+to_string(rates[2]);
+    logger->writeMsg(msg.c_str(), DEBUG);
+    
+    return ts;
+}
+
+
+//  everything carried from one step to the next, halos are flushed first
+void Solver::saveState(){
+    gridMng->flushHalos(nullptr);
+    gridMng->saveState();
+    pusher->saveState();
+    closureMng->saveState();
+}
+
+
+void Solver::restoreState(){
+    gridMng->restoreState();
+    pusher->restoreState();
+    closureMng->restoreState();
+}
+
+
+double Solver::getSimulationTime(){
+    return simulationTime;
+}
+
 
-    emMng->calculateBnext();
-    emMng->calculateJnext();
+int Solver::getRejectedStepsNum(){
+    return rejectedSteps;
+}
+
+
+double Solver::getMinUsedTimeStep(){
+    return minUsedTimeStep;
+}
+
+
+double Solver::getMaxUsedTimeStep(){
+    return maxUsedTimeStep;
+}
+
+
+void Solver::performCalculation(int PHASE, int i_time){
+    logger->writeMsg("[Solver] in performCalculation()...", DEBUG);
+    
+    currentStep = i_time;
+    
+    TaskGraph& graph = phaseGraphs[PHASE];
+    graph.run();
     
 //    if (PHASE == CORRECTOR) pusher->checkEnergyBalance(i_time);
     
+    vector<int> path;
+    double pathTime = graph.getCriticalPath(path);
+    criticalPathTime += pathTime;
+    stagesTime += graph.getTotalTime();
+    
+    string msg = "[Solver] "+string(PHASE == PREDICTOR ? "PREDICTOR" : "CORRECTOR")
+                +" critical path = "+to_string(pathTime)+" ms of "+to_string(graph.getTotalTime())
+                +" ms: "+graph.getCriticalPathNames();
+    logger->writeMsg(msg.c_str(), DEBUG);
+    
     logger->writeMsg("[Solver] performCaclculation...OK", DEBUG);
 }
 
 
+double Solver::getCriticalPathTime(){
+    return criticalPathTime;
+}
+
+
+double Solver::getStagesTime(){
+    return stagesTime;
+}
+
+
 
 Solver::~Solver(){
     finilize();
@@ -21,10 +21,16 @@
 #include "../physics/laser/LaserMockManager.hpp"
 #include "../physics/collisions/IonIonCollisionManager.hpp"
 
+#include "TaskGraph.hpp"
+
 
 const static int  SOLVE_OK   = 0;
 const static int  SOLVE_FAIL = 1;
 
+//  adaptive timestep: cut of a rejected step, growth after a clean one
+const static double TIMESTEP_CUT    = 0.5;
+const static double TIMESTEP_GROWTH = 1.1;
+
 class Solver
 {
     
@@ -42,7 +48,26 @@ private:
     std::shared_ptr<IonIonCollisionManager> collideMng;
     
     
+    //# stages of the predictor and the corrector
+    TaskGraph phaseGraphs[2];
+    int currentStep = 0;
+    double criticalPathTime = 0.0;
+    double stagesTime = 0.0;
+    
+    void buildPhaseGraph(int);
     void performCalculation(int, int);
+    
+    //# physical time at the start of the next step, the timestep may vary
+    double simulationTime = 0.0;
+    
+    int rejectedSteps = 0;
+    double minUsedTimeStep = 0.0;
+    double maxUsedTimeStep = 0.0;
+    
+    int solveAdaptive(int);
+    double getStableTimeStep();
+    void saveState();
+    void restoreState();
 
     
 public:
@@ -53,6 +78,12 @@ public:
         
     void initialize();
     int solve(int);
+    double getSimulationTime();
+    int getRejectedStepsNum();
+    double getMinUsedTimeStep();
+    double getMaxUsedTimeStep();
+    double getCriticalPathTime();
+    double getStagesTime();
     void finilize();
     ~Solver();
 };
@@ -0,0 +1,281 @@
+#include "TaskGraph.hpp"
+
+
+using namespace std;
+using namespace chrono;
+
+
+bool TaskGraph::conflict(const vector<string>& first, const vector<string>& second){
+    for( int n = 0; n < first.size(); n++ ){
+        for( int m = 0; m < second.size(); m++ ){
+            if( first[n] == second[m] ){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+
+int TaskGraph::addTask(const string& name, const vector<string>& reads,
+                       const vector<string>& writes, int communication, function<void()> run){
+    Task task;
+    task.name = name;
+    task.reads = reads;
+    task.writes = writes;
+    task.communication = communication;
+    task.run = run;
+    task.duration = 0.0;
+
+    for( int prev = 0; prev < tasks.size(); prev++ ){
+        if( conflict(reads, tasks[prev].writes)
+           || conflict(writes, tasks[prev].reads)
+           || conflict(writes, tasks[prev].writes) ){
+            task.deps.push_back(prev);
+        }
+    }
+
+    tasks.push_back(task);
+    orderCommunication();
+    return tasks.size()-1;
+}
+
+
+//  workers need MPI initialised with at least MPI_THREAD_FUNNELED
+void TaskGraph::setWorkers(bool workers){
+    useWorkers = workers;
+}
+
+
+//  every task the given one depends on is marked in done
+bool TaskGraph::isReady(int n, const vector<int>& done){
+    for( int d = 0; d < tasks[n].deps.size(); d++ ){
+        if( !done[tasks[n].deps[d]] ){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//  order of the communication tasks, the same on every domain so that
+//  the exchanges match: a communication task goes first when it needs no
+//  task of the workers that has not been waited for, and the workers are
+//  waited for only when no such communication task is left
+void TaskGraph::orderCommunication(){
+
+    int tasksNum = tasks.size();
+    vector<int> placed(tasksNum, 0);
+    int left = tasksNum;
+
+    masterOrder.clear();
+    while( left > 0 ){
+        int next = -1;
+        for( int n = 0; n < tasksNum && next < 0; n++ ){
+            if( !placed[n] && tasks[n].communication && isReady(n, placed) ){
+                next = n;
+            }
+        }
+        if( next >= 0 ){
+            placed[next] = 1;
+            masterOrder.push_back(next);
+            left--;
+            continue;
+        }
+        for( int n = 0; n < tasksNum; n++ ){
+            if( !placed[n] && !tasks[n].communication && isReady(n, placed) ){
+                placed[n] = 1;
+                left--;
+            }
+        }
+    }
+}
+
+
+void TaskGraph::runTask(int n){
+    auto start_time = high_resolution_clock::now();
+    tasks[n].run();
+    auto end_time = high_resolution_clock::now();
+    tasks[n].duration = duration_cast<microseconds>(end_time - start_time).count()/1000.0;
+}
+
+
+//  without workers the tasks run one after another in the order they were
+//  added. With workers a task without communication is started on a thread
+//  once its dependencies are done and the calling thread runs the
+//  communication tasks in masterOrder, waiting for the workers they need.
+//  A failed task stops new tasks from starting, the running ones are
+//  finished and the error is thrown again. A worker starts with the
+//  OpenMP threads of the calling thread, a new thread would otherwise get
+//  the default team size. The durations give the critical path
+void TaskGraph::run(){
+
+    int tasksNum = tasks.size();
+
+    if( !useWorkers ){
+        for( int n = 0; n < tasksNum; n++ ){
+            runTask(n);
+        }
+        return;
+    }
+
+    vector<int> started(tasksNum, 0), done(tasksNum, 0);
+    vector<thread> workers;
+    int running = 0;
+    int next = 0;
+    int threadsNum = getThreadsNum();
+    exception_ptr failure;
+
+    mutex lock;
+    condition_variable finished;
+    unique_lock<mutex> guard(lock);
+
+    while( true ){
+        for( int n = 0; n < tasksNum && !failure; n++ ){
+            if( !started[n] && !tasks[n].communication && isReady(n, done) ){
+                started[n] = 1;
+                running++;
+                workers.push_back(thread([this, n, threadsNum, &lock, &finished, &done, &running, &failure](){
+                    exception_ptr error;
+                    setThreadsNum(threadsNum);
+                    try{
+                        runTask(n);
+                    }catch(...){
+                        error = current_exception();
+                    }
+                    lock_guard<mutex> workerGuard(lock);
+                    if( error && !failure ){
+                        failure = error;
+                    }
+                    done[n] = 1;
+                    running--;
+                    finished.notify_one();
+                }));
+            }
+        }
+
+        if( !failure && next < masterOrder.size() && isReady(masterOrder[next], done) ){
+            int n = masterOrder[next++];
+            guard.unlock();
+            exception_ptr error;
+            try{
+                runTask(n);
+            }catch(...){
+                error = current_exception();
+            }
+            guard.lock();
+            if( error && !failure ){
+                failure = error;
+            }
+            done[n] = 1;
+            continue;
+        }
+
+        if( running == 0 && (failure || next == masterOrder.size()) ){
+            break;
+        }
+        finished.wait(guard);
+    }
+    guard.unlock();
+
+    for( int w = 0; w < workers.size(); w++ ){
+        workers[w].join();
+    }
+
+    if( failure ){
+        rethrow_exception(failure);
+    }
+}
+
+
+double TaskGraph::getTotalTime(){
+    double total = 0.0;
+    for( int n = 0; n < tasks.size(); n++ ){
+        total += tasks[n].duration;
+    }
+    return total;
+}
+
+
+//  longest chain of dependent tasks of the last run, in ms
+double TaskGraph::getCriticalPath(vector<int>& path){
+
+    int tasksNum = tasks.size();
+    vector<double> finish(tasksNum, 0.0);
+    vector<int> before(tasksNum, -1);
+    int last = -1;
+
+    for( int n = 0; n < tasksNum; n++ ){
+        for( int d = 0; d < tasks[n].deps.size(); d++ ){
+            int dep = tasks[n].deps[d];
+            if( finish[dep] > finish[n] ){
+                finish[n] = finish[dep];
+                before[n] = dep;
+            }
+        }
+        finish[n] += tasks[n].duration;
+        if( last < 0 || finish[n] > finish[last] ){
+            last = n;
+        }
+    }
+
+    path.clear();
+    for( int n = last; n >= 0; n = before[n] ){
+        path.insert(path.begin(), n);
+    }
+
+    return last < 0 ? 0.0 : finish[last];
+}
+
+
+string TaskGraph::getCriticalPathNames(){
+    vector<int> path;
+    getCriticalPath(path);
+
+    string names;
+    for( int n = 0; n < path.size(); n++ ){
+        names += (n == 0 ? "" : " > ")+tasks[path[n]].name;
+    }
+    return names;
+}
+
+
+//  graph in the dot format, communication tasks are drawn as ellipses
+//  and every edge is labelled with the data of the conflict
+string TaskGraph::toDot(const string& graphName){
+
+    string dot = "digraph "+graphName+" {\n";
+
+    for( int n = 0; n < tasks.size(); n++ ){
+        dot += "    t"+to_string(n)+" [label=\""+tasks[n].name+"\", shape="
+              +(tasks[n].communication ? "ellipse" : "box")+"];\n";
+    }
+
+    for( int n = 0; n < tasks.size(); n++ ){
+        for( int d = 0; d < tasks[n].deps.size(); d++ ){
+            const Task& prev = tasks[tasks[n].deps[d]];
+            vector<string> shared;
+            for( int r = 0; r < tasks[n].reads.size(); r++ ){
+                if( conflict({tasks[n].reads[r]}, prev.writes) ){
+                    shared.push_back(tasks[n].reads[r]);
+                }
+            }
+            for( int w = 0; w < tasks[n].writes.size(); w++ ){
+                if( (conflict({tasks[n].writes[w]}, prev.writes)
+                    || conflict({tasks[n].writes[w]}, prev.reads))
+                   && !conflict({tasks[n].writes[w]}, shared) ){
+                    shared.push_back(tasks[n].writes[w]);
+                }
+            }
+            string label;
+            for( int v = 0; v < shared.size(); v++ ){
+                label += (v == 0 ? "" : ",")+shared[v];
+            }
+            dot += "    t"+to_string(tasks[n].deps[d])+" -> t"+to_string(n)
+                  +" [label=\""+label+"\"];\n";
+        }
+    }
+
+    dot += "}";
+    return dot;
+}
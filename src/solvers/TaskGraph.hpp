@@ -0,0 +1,71 @@
+//
+//  TaskGraph.hpp
+
+#ifndef TaskGraph_hpp
+#define TaskGraph_hpp
+
+#include <chrono>
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+#include "../misc/Threads.hpp"
+
+
+//  stage of a solver phase with the data it reads and writes,
+//  a communication stage exchanges halos or particles between domains
+struct Task{
+    std::string name;
+    std::vector<std::string> reads;
+    std::vector<std::string> writes;
+    int communication;
+    std::function<void()> run;
+
+    //# earlier tasks with a conflicting access, set when the task is added
+    std::vector<int> deps;
+    double duration;
+};
+
+
+//  dependency graph of the stages of a phase: a task depends on every
+//  earlier task it has a read-after-write, write-after-read or
+//  write-after-write conflict with. The order the tasks are added in is
+//  then a valid order of execution, and the longest chain of dependent
+//  tasks is the time the phase would take with independent tasks overlapped.
+//  With workers the tasks without communication run on threads of their
+//  own as soon as their dependencies are done, while the calling thread
+//  runs the communication tasks, the only ones calling MPI
+class TaskGraph{
+
+private:
+
+    std::vector<Task> tasks;
+    bool useWorkers = false;
+
+    //# communication tasks in the order the calling thread runs them
+    std::vector<int> masterOrder;
+
+    static bool conflict(const std::vector<std::string>&, const std::vector<std::string>&);
+    bool isReady(int, const std::vector<int>&);
+    void orderCommunication();
+    void runTask(int);
+
+public:
+
+    int addTask(const std::string&, const std::vector<std::string>&,
+                const std::vector<std::string>&, int, std::function<void()>);
+    void setWorkers(bool);
+    void run();
+
+    double getTotalTime();
+    double getCriticalPath(std::vector<int>&);
+    std::string getCriticalPathNames();
+    std::string toDot(const std::string&);
+};
+
+#endif